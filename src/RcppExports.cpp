@@ -1,6 +1,7 @@
 // Generated by using Rcpp::compileAttributes() -> do not edit by hand
 // Generator token: 10BE3573-1514-4C36-9D1C-5A225CD40393
 
+#include "sphereTessellation_types.h"
 #include <RcppEigen.h>
 #include <Rcpp.h>
 
@@ -11,9 +12,42 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// delaunay_batch_cpp
+Rcpp::List delaunay_batch_cpp(Rcpp::List pts, Rcpp::IntegerVector groups, int ngroups, double radius, Rcpp::NumericVector O, int niter, bool meshes, int nthreads, double tolerance, bool compact, double epsilon);
+RcppExport SEXP _sphereTessellation_delaunay_batch_cpp(SEXP ptsSEXP, SEXP groupsSEXP, SEXP ngroupsSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP niterSEXP, SEXP meshesSEXP, SEXP nthreadsSEXP, SEXP toleranceSEXP, SEXP compactSEXP, SEXP epsilonSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type pts(ptsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type groups(groupsSEXP);
+    Rcpp::traits::input_parameter< int >::type ngroups(ngroupsSEXP);
+    Rcpp::traits::input_parameter< double >::type radius(radiusSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type O(OSEXP);
+    Rcpp::traits::input_parameter< int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< bool >::type meshes(meshesSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< double >::type epsilon(epsilonSEXP);
+    rcpp_result_gen = Rcpp::wrap(delaunay_batch_cpp(pts, groups, ngroups, radius, O, niter, meshes, nthreads, tolerance, compact, epsilon));
+    return rcpp_result_gen;
+END_RCPP
+}
+// kernels_benchmark
+Rcpp::List kernels_benchmark(int level, int repetitions);
+RcppExport SEXP _sphereTessellation_kernels_benchmark(SEXP levelSEXP, SEXP repetitionsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type level(levelSEXP);
+    Rcpp::traits::input_parameter< int >::type repetitions(repetitionsSEXP);
+    rcpp_result_gen = Rcpp::wrap(kernels_benchmark(level, repetitions));
+    return rcpp_result_gen;
+END_RCPP
+}
 // delaunay_cpp
-Rcpp::List delaunay_cpp(Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter);
-RcppExport SEXP _sphereTessellation_delaunay_cpp(SEXP ptsSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP niterSEXP) {
+Rcpp::List delaunay_cpp(Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter, bool meshes, bool spatialsort, int nthreads, bool profiling, double tolerance, bool lod, bool parallel, bool compact, bool metrics, double epsilon);
+RcppExport SEXP _sphereTessellation_delaunay_cpp(SEXP ptsSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP niterSEXP, SEXP meshesSEXP, SEXP spatialsortSEXP, SEXP nthreadsSEXP, SEXP profilingSEXP, SEXP toleranceSEXP, SEXP lodSEXP, SEXP parallelSEXP, SEXP compactSEXP, SEXP metricsSEXP, SEXP epsilonSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -21,13 +55,40 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< double >::type radius(radiusSEXP);
     Rcpp::traits::input_parameter< Rcpp::NumericVector >::type O(OSEXP);
     Rcpp::traits::input_parameter< int >::type niter(niterSEXP);
-    rcpp_result_gen = Rcpp::wrap(delaunay_cpp(pts, radius, O, niter));
+    Rcpp::traits::input_parameter< bool >::type meshes(meshesSEXP);
+    Rcpp::traits::input_parameter< bool >::type spatialsort(spatialsortSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type profiling(profilingSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< bool >::type lod(lodSEXP);
+    Rcpp::traits::input_parameter< bool >::type parallel(parallelSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< bool >::type metrics(metricsSEXP);
+    Rcpp::traits::input_parameter< double >::type epsilon(epsilonSEXP);
+    rcpp_result_gen = Rcpp::wrap(delaunay_cpp(pts, radius, O, niter, meshes, spatialsort, nthreads, profiling, tolerance, lod, parallel, compact, metrics, epsilon));
+    return rcpp_result_gen;
+END_RCPP
+}
+// lloyd_cpp
+Rcpp::List lloyd_cpp(Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter, double tolerance, bool spatialsort, int nthreads);
+RcppExport SEXP _sphereTessellation_lloyd_cpp(SEXP ptsSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP niterSEXP, SEXP toleranceSEXP, SEXP spatialsortSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type pts(ptsSEXP);
+    Rcpp::traits::input_parameter< double >::type radius(radiusSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type O(OSEXP);
+    Rcpp::traits::input_parameter< int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< bool >::type spatialsort(spatialsortSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(lloyd_cpp(pts, radius, O, niter, tolerance, spatialsort, nthreads));
     return rcpp_result_gen;
 END_RCPP
 }
 // sTriangle
-Rcpp::List sTriangle(Rcpp::NumericVector A, Rcpp::NumericVector B, Rcpp::NumericVector C, double radius, Rcpp::NumericVector O, int iterations);
-RcppExport SEXP _sphereTessellation_sTriangle(SEXP ASEXP, SEXP BSEXP, SEXP CSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP iterationsSEXP) {
+Rcpp::List sTriangle(Rcpp::NumericVector A, Rcpp::NumericVector B, Rcpp::NumericVector C, double radius, Rcpp::NumericVector O, int iterations, bool profiling, double tolerance);
+RcppExport SEXP _sphereTessellation_sTriangle(SEXP ASEXP, SEXP BSEXP, SEXP CSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP iterationsSEXP, SEXP profilingSEXP, SEXP toleranceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -37,13 +98,186 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< double >::type radius(radiusSEXP);
     Rcpp::traits::input_parameter< Rcpp::NumericVector >::type O(OSEXP);
     Rcpp::traits::input_parameter< int >::type iterations(iterationsSEXP);
-    rcpp_result_gen = Rcpp::wrap(sTriangle(A, B, C, radius, O, iterations));
+    Rcpp::traits::input_parameter< bool >::type profiling(profilingSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    rcpp_result_gen = Rcpp::wrap(sTriangle(A, B, C, radius, O, iterations, profiling, tolerance));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_new
+Rcpp::XPtr<Tessellation> tessellation_new(Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O);
+RcppExport SEXP _sphereTessellation_tessellation_new(SEXP ptsSEXP, SEXP radiusSEXP, SEXP OSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type pts(ptsSEXP);
+    Rcpp::traits::input_parameter< double >::type radius(radiusSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type O(OSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_new(pts, radius, O));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_insert
+Rcpp::IntegerVector tessellation_insert(Rcpp::XPtr<Tessellation> xptr, Rcpp::NumericMatrix pts);
+RcppExport SEXP _sphereTessellation_tessellation_insert(SEXP xptrSEXP, SEXP ptsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type pts(ptsSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_insert(xptr, pts));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_remove
+void tessellation_remove(Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids);
+RcppExport SEXP _sphereTessellation_tessellation_remove(SEXP xptrSEXP, SEXP idsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type ids(idsSEXP);
+    tessellation_remove(xptr, ids);
+    return R_NilValue;
+END_RCPP
+}
+// tessellation_move
+void tessellation_move(Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids, Rcpp::NumericMatrix pts);
+RcppExport SEXP _sphereTessellation_tessellation_move(SEXP xptrSEXP, SEXP idsSEXP, SEXP ptsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type ids(idsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type pts(ptsSEXP);
+    tessellation_move(xptr, ids, pts);
+    return R_NilValue;
+END_RCPP
+}
+// tessellation_sites
+Rcpp::List tessellation_sites(Rcpp::XPtr<Tessellation> xptr);
+RcppExport SEXP _sphereTessellation_tessellation_sites(SEXP xptrSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_sites(xptr));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_cells
+Rcpp::List tessellation_cells(Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids);
+RcppExport SEXP _sphereTessellation_tessellation_cells(SEXP xptrSEXP, SEXP idsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type ids(idsSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_cells(xptr, ids));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_faces
+Rcpp::IntegerMatrix tessellation_faces(Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids);
+RcppExport SEXP _sphereTessellation_tessellation_faces(SEXP xptrSEXP, SEXP idsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type ids(idsSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_faces(xptr, ids));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_locate
+Rcpp::List tessellation_locate(Rcpp::XPtr<Tessellation> xptr, Rcpp::NumericMatrix pts, int nthreads);
+RcppExport SEXP _sphereTessellation_tessellation_locate(SEXP xptrSEXP, SEXP ptsSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type pts(ptsSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_locate(xptr, pts, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_changes
+Rcpp::List tessellation_changes(Rcpp::XPtr<Tessellation> xptr);
+RcppExport SEXP _sphereTessellation_tessellation_changes(SEXP xptrSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_changes(xptr));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_voronoi_mesh
+Rcpp::List tessellation_voronoi_mesh(Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids, int niter, double tolerance, int nthreads);
+RcppExport SEXP _sphereTessellation_tessellation_voronoi_mesh(SEXP xptrSEXP, SEXP idsSEXP, SEXP niterSEXP, SEXP toleranceSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type ids(idsSEXP);
+    Rcpp::traits::input_parameter< int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_voronoi_mesh(xptr, ids, niter, tolerance, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// tessellation_delaunay_mesh
+Rcpp::List tessellation_delaunay_mesh(Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids, int niter, double tolerance, int nthreads);
+RcppExport SEXP _sphereTessellation_tessellation_delaunay_mesh(SEXP xptrSEXP, SEXP idsSEXP, SEXP niterSEXP, SEXP toleranceSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<Tessellation> >::type xptr(xptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type ids(idsSEXP);
+    Rcpp::traits::input_parameter< int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(tessellation_delaunay_mesh(xptr, ids, niter, tolerance, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// mesh_indices_cpp
+Rcpp::IntegerMatrix mesh_indices_cpp(Rcpp::RawVector Bytes);
+RcppExport SEXP _sphereTessellation_mesh_indices_cpp(SEXP BytesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::RawVector >::type Bytes(BytesSEXP);
+    rcpp_result_gen = Rcpp::wrap(mesh_indices_cpp(Bytes));
     return rcpp_result_gen;
 END_RCPP
 }
 // voronoi_cpp
-Rcpp::List voronoi_cpp(Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter);
-RcppExport SEXP _sphereTessellation_voronoi_cpp(SEXP ptsSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP niterSEXP) {
+Rcpp::List voronoi_cpp(Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter, bool meshes, bool spatialsort, int nthreads, bool profiling, double tolerance, bool compact, bool metrics, double epsilon, bool gradient);
+RcppExport SEXP _sphereTessellation_voronoi_cpp(SEXP ptsSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP niterSEXP, SEXP meshesSEXP, SEXP spatialsortSEXP, SEXP nthreadsSEXP, SEXP profilingSEXP, SEXP toleranceSEXP, SEXP compactSEXP, SEXP metricsSEXP, SEXP epsilonSEXP, SEXP gradientSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type pts(ptsSEXP);
+    Rcpp::traits::input_parameter< double >::type radius(radiusSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type O(OSEXP);
+    Rcpp::traits::input_parameter< int >::type niter(niterSEXP);
+    Rcpp::traits::input_parameter< bool >::type meshes(meshesSEXP);
+    Rcpp::traits::input_parameter< bool >::type spatialsort(spatialsortSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type profiling(profilingSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< bool >::type metrics(metricsSEXP);
+    Rcpp::traits::input_parameter< double >::type epsilon(epsilonSEXP);
+    Rcpp::traits::input_parameter< bool >::type gradient(gradientSEXP);
+    rcpp_result_gen = Rcpp::wrap(voronoi_cpp(pts, radius, O, niter, meshes, spatialsort, nthreads, profiling, tolerance, compact, metrics, epsilon, gradient));
+    return rcpp_result_gen;
+END_RCPP
+}
+// voronoi_write_cpp
+Rcpp::List voronoi_write_cpp(Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter, bool spatialsort, int nthreads, std::string filename, bool ply, int chunksize);
+RcppExport SEXP _sphereTessellation_voronoi_write_cpp(SEXP ptsSEXP, SEXP radiusSEXP, SEXP OSEXP, SEXP niterSEXP, SEXP spatialsortSEXP, SEXP nthreadsSEXP, SEXP filenameSEXP, SEXP plySEXP, SEXP chunksizeSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -51,15 +285,62 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< double >::type radius(radiusSEXP);
     Rcpp::traits::input_parameter< Rcpp::NumericVector >::type O(OSEXP);
     Rcpp::traits::input_parameter< int >::type niter(niterSEXP);
-    rcpp_result_gen = Rcpp::wrap(voronoi_cpp(pts, radius, O, niter));
+    Rcpp::traits::input_parameter< bool >::type spatialsort(spatialsortSEXP);
+    Rcpp::traits::input_parameter< int >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< bool >::type ply(plySEXP);
+    Rcpp::traits::input_parameter< int >::type chunksize(chunksizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(voronoi_write_cpp(pts, radius, O, niter, spatialsort, nthreads, filename, ply, chunksize));
+    return rcpp_result_gen;
+END_RCPP
+}
+// voronoi_file_info
+Rcpp::List voronoi_file_info(std::string filename);
+RcppExport SEXP _sphereTessellation_voronoi_file_info(SEXP filenameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    rcpp_result_gen = Rcpp::wrap(voronoi_file_info(filename));
+    return rcpp_result_gen;
+END_RCPP
+}
+// voronoi_read_cpp
+Rcpp::List voronoi_read_cpp(std::string filename, Rcpp::IntegerVector ids, bool all);
+RcppExport SEXP _sphereTessellation_voronoi_read_cpp(SEXP filenameSEXP, SEXP idsSEXP, SEXP allSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type ids(idsSEXP);
+    Rcpp::traits::input_parameter< bool >::type all(allSEXP);
+    rcpp_result_gen = Rcpp::wrap(voronoi_read_cpp(filename, ids, all));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_sphereTessellation_delaunay_cpp", (DL_FUNC) &_sphereTessellation_delaunay_cpp, 4},
-    {"_sphereTessellation_sTriangle", (DL_FUNC) &_sphereTessellation_sTriangle, 6},
-    {"_sphereTessellation_voronoi_cpp", (DL_FUNC) &_sphereTessellation_voronoi_cpp, 4},
+    {"_sphereTessellation_delaunay_batch_cpp", (DL_FUNC) &_sphereTessellation_delaunay_batch_cpp, 11},
+    {"_sphereTessellation_kernels_benchmark", (DL_FUNC) &_sphereTessellation_kernels_benchmark, 2},
+    {"_sphereTessellation_delaunay_cpp", (DL_FUNC) &_sphereTessellation_delaunay_cpp, 14},
+    {"_sphereTessellation_lloyd_cpp", (DL_FUNC) &_sphereTessellation_lloyd_cpp, 7},
+    {"_sphereTessellation_sTriangle", (DL_FUNC) &_sphereTessellation_sTriangle, 8},
+    {"_sphereTessellation_tessellation_new", (DL_FUNC) &_sphereTessellation_tessellation_new, 3},
+    {"_sphereTessellation_tessellation_insert", (DL_FUNC) &_sphereTessellation_tessellation_insert, 2},
+    {"_sphereTessellation_tessellation_remove", (DL_FUNC) &_sphereTessellation_tessellation_remove, 2},
+    {"_sphereTessellation_tessellation_move", (DL_FUNC) &_sphereTessellation_tessellation_move, 3},
+    {"_sphereTessellation_tessellation_sites", (DL_FUNC) &_sphereTessellation_tessellation_sites, 1},
+    {"_sphereTessellation_tessellation_cells", (DL_FUNC) &_sphereTessellation_tessellation_cells, 2},
+    {"_sphereTessellation_tessellation_faces", (DL_FUNC) &_sphereTessellation_tessellation_faces, 2},
+    {"_sphereTessellation_tessellation_locate", (DL_FUNC) &_sphereTessellation_tessellation_locate, 3},
+    {"_sphereTessellation_tessellation_changes", (DL_FUNC) &_sphereTessellation_tessellation_changes, 1},
+    {"_sphereTessellation_tessellation_voronoi_mesh", (DL_FUNC) &_sphereTessellation_tessellation_voronoi_mesh, 5},
+    {"_sphereTessellation_tessellation_delaunay_mesh", (DL_FUNC) &_sphereTessellation_tessellation_delaunay_mesh, 5},
+    {"_sphereTessellation_mesh_indices_cpp", (DL_FUNC) &_sphereTessellation_mesh_indices_cpp, 1},
+    {"_sphereTessellation_voronoi_cpp", (DL_FUNC) &_sphereTessellation_voronoi_cpp, 13},
+    {"_sphereTessellation_voronoi_write_cpp", (DL_FUNC) &_sphereTessellation_voronoi_write_cpp, 9},
+    {"_sphereTessellation_voronoi_file_info", (DL_FUNC) &_sphereTessellation_voronoi_file_info, 1},
+    {"_sphereTessellation_voronoi_read_cpp", (DL_FUNC) &_sphereTessellation_voronoi_read_cpp, 3},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,219 @@
+#include "sphereTessellation.h"
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Batch of Delaunay triangulations. The groups of points are triangulated in
+// parallel, each thread reusing its own arena from one group to the next:
+// the buffers of the projection, of the merging of the close points and of
+// the subdivision, which keep their capacities. The triangulation object is
+// reused as well, but clearing it releases the storage of its vertices and
+// faces, which is allocated again for each group. The groups are processed by
+// waves of a few groups per thread: once a wave is done, the calling thread
+// converts its groups to R objects, in order, and releases their buffers, so
+// that the C++ results of at most one wave are held in memory.
+
+// group of points: the rows `rows` of the column-major matrix with `nrow`
+// rows and three columns at `data`, or all its rows if `rows` is empty
+struct BatchGroup {
+  const double*    data;
+  int              nrow;
+  std::vector<int> rows;
+};
+
+// arena of a thread
+struct BatchArena {
+  DToS                       dtos;
+  std::vector<PointOnSphere> spoints;
+  std::vector<SPoint3>       projections;
+  std::vector<double>        vertices;
+  std::vector<int>           solidFaces;
+  MergeScratch               merge;
+  FaceScratch                scratch;
+  explicit BatchArena(const Traits& ball) : dtos(ball) {}
+};
+
+// triangulation of a group, without any R object
+struct BatchResult {
+  int                 dim;
+  std::vector<double> vertices;
+  std::vector<int>    faces;
+  std::vector<char>   ghosts;
+  std::vector<int>    mapping;
+  SMesh               smesh;
+};
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// triangulates a group of points with the arena of the running thread
+void batchTriangulation(
+    const BatchGroup& group, int level, double tolerance, bool meshes,
+    double epsilon, BatchArena& arena, BatchResult& result
+) {
+  DToS& dtos = arena.dtos;
+  const Traits& ball = dtos.geom_traits();
+  const SPoint3 O = ball.center();
+  const double radius = ball.radius();
+  Traits::Construct_point_on_sphere_2 projection =
+    ball.construct_point_on_sphere_2_object();
+  const int npoints = group.rows.empty() ? group.nrow : group.rows.size();
+  arena.spoints.clear();
+  arena.projections.clear();
+  for(int k = 0; k < npoints; k++) {
+    const int i = group.rows.empty() ? k : group.rows[k];
+    const double* p = group.data + i;
+    const PointOnSphere pos =
+      projection(SPoint3(p[0], p[group.nrow], p[2 * group.nrow]));
+    arena.spoints.push_back(pos);
+    arena.projections.push_back(pos.get_projection(O, radius));
+  }
+  mergePoints(
+    arena.spoints, arena.projections, O, radius, epsilon, arena.merge,
+    result.mapping
+  );
+  dtos.clear();
+  const std::vector<DToS::Vertex_handle> vhs = insertPoints(
+    dtos, arena.spoints, arena.projections,
+    arena.projections.size() >= 1000, 1
+  );
+  mergeVertices(
+    dtos, vhs, arena.spoints, arena.projections, result.mapping
+  );
+  result.dim = dtos.dimension();
+  if(result.dim != 2) {
+    return;
+  }
+  triangulationFaces(dtos, result.faces, result.ghosts);
+  const int nvertices = arena.projections.size();
+  sortFaces(result.faces, result.ghosts, nvertices);
+  result.vertices.resize(3 * nvertices);
+  for(int i = 0; i < nvertices; i++) {
+    const SPoint3& p = arena.projections[i];
+    result.vertices[3*i]     = p.x();
+    result.vertices[3*i + 1] = p.y();
+    result.vertices[3*i + 2] = p.z();
+  }
+  if(!meshes) {
+    return;
+  }
+  arena.solidFaces.clear();
+  for(size_t f = 0; f < result.ghosts.size(); f++) {
+    if(!result.ghosts[f]) {
+      for(int k = 0; k < 3; k++) {
+        arena.solidFaces.push_back(result.faces[3*f + k] - 1);
+      }
+    }
+  }
+  const double center[3] = {O.x(), O.y(), O.z()};
+  subdivideMeshScratch(
+    result.vertices, arena.solidFaces, level, tolerance, radius, center,
+    arena.scratch, result.smesh
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// output of a triangulation of the batch, as the one of delaunay_cpp
+Rcpp::List batchToList(
+    const BatchResult& result, bool meshes, bool compact, const double* O
+) {
+  const int nvertices = result.vertices.size() / 3;
+  const int nfaces = result.ghosts.size();
+  Rcpp::NumericMatrix Vertices(nvertices, 3);
+  for(int i = 0; i < nvertices; i++) {
+    for(int j = 0; j < 3; j++) {
+      Vertices(i, j) = result.vertices[3*i + j];
+    }
+  }
+  Rcpp::IntegerMatrix Faces(nfaces, 3);
+  for(int f = 0; f < nfaces; f++) {
+    for(int k = 0; k < 3; k++) {
+      Faces(f, k) = result.faces[3*f + k];
+    }
+  }
+  const int nsolidFaces =
+    nfaces - std::count(result.ghosts.begin(), result.ghosts.end(), true);
+  Rcpp::IntegerVector SolidFaces(nsolidFaces);
+  int solidfaceIndex = 0;
+  for(int f = 0; f < nfaces; f++) {
+    if(!result.ghosts[f]) {
+      SolidFaces(solidfaceIndex++) = f + 1;
+    }
+  }
+  Rcpp::List Delaunay = Rcpp::List::create(
+    Rcpp::Named("vertices")   = Vertices,
+    Rcpp::Named("faces")      = Faces,
+    Rcpp::Named("solidFaces") = SolidFaces,
+    Rcpp::Named("mapping")    = rowMapping(result.mapping)
+  );
+  if(meshes) {
+    Delaunay["mesh"] = compact
+      ? SMeshToCompactList(result.smesh, 1) : SMeshToList(result.smesh, O);
+  }
+  return Delaunay;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Delaunay triangulations of some groups of points: `pts` is a list of
+// matrices with three columns, or a single matrix, in which case `groups`
+// gives the one-based group of each row, `ngroups` being their number.
+// [[Rcpp::export]]
+Rcpp::List delaunay_batch_cpp(
+    Rcpp::List pts, Rcpp::IntegerVector groups, int ngroups, double radius,
+    Rcpp::NumericVector O, int niter, bool meshes, int nthreads,
+    double tolerance = 0, bool compact = false, double epsilon = 0
+) {
+  // the groups, whose points are read in place: the matrices must be double
+  // matrices, otherwise their conversions would not outlive this block
+  std::vector<BatchGroup> batch;
+  if(groups.size() == 0) {
+    ngroups = pts.size();
+    for(int g = 0; g < ngroups; g++) {
+      const Rcpp::NumericMatrix M = pts[g];
+      batch.push_back({M.begin(), M.nrow(), std::vector<int>()});
+    }
+  } else {
+    const Rcpp::NumericMatrix M = pts[0];
+    batch.assign(ngroups, {M.begin(), M.nrow(), std::vector<int>()});
+    for(int i = 0; i < groups.size(); i++) {
+      batch[groups(i) - 1].rows.push_back(i);
+    }
+  }
+  const Traits ball(SPoint3(O(0), O(1), O(2)), radius);
+  nthreads = std::max(1, std::min(nthreads, ngroups));
+  std::vector<std::unique_ptr<BatchArena>> arenas;
+  for(int t = 0; t < nthreads; t++) {
+    arenas.emplace_back(new BatchArena(ball));
+  }
+  const int wave = 8 * nthreads;
+  std::vector<BatchResult> results(std::min(wave, ngroups));
+  const double center[3] = {O(0), O(1), O(2)};
+  Rcpp::List Batch(ngroups);
+  for(int first = 0; first < ngroups; first += wave) {
+    const int n = std::min(wave, ngroups - first);
+    parallelFor(n, nthreads, [&](int begin, int end, int thread) {
+      for(int g = begin; g < end; g++) {
+        batchTriangulation(
+          batch[first + g], niter - 1, tolerance, meshes, epsilon,
+          *arenas[thread], results[g]
+        );
+      }
+    }, 1);
+    // the groups of the wave are converted one after the other, their C++
+    // buffers being released as soon as possible
+    for(int g = 0; g < n; g++) {
+      if(results[g].dim != 2) {
+        Rcpp::stop(
+          "The triangulation of the group " + std::to_string(first + g + 1) +
+            " has less than three vertices or is drawn on a circle."
+        );
+      }
+      Rcpp::List Delaunay = batchToList(results[g], meshes, compact, center);
+      Delaunay.attr("radius") = radius;
+      Delaunay.attr("center") = O;
+      Batch(first + g) = Delaunay;
+      results[g] = BatchResult();
+    }
+  }
+  return Batch;
+}
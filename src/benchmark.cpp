@@ -0,0 +1,96 @@
+#include "sphereTessellation.h"
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// mean time in seconds of `repetitions` calls of `f`
+template <typename F>
+double meanSeconds(int repetitions, F f) {
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  for(int r = 0; r < repetitions; r++) {
+    f();
+  }
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start
+  ).count() / repetitions;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Times the streaming kernels of the subdivision on the grid of an octant of
+// the unit sphere subdivided `level` times: the portable kernels against the
+// ones selected for the processor, and the midpoints against the inlined
+// subdivision used for the levels up to 5. The grids and the vertex buffers
+// computed by the kernels and by the inlined subdivision, at `level` and at
+// the levels 0 to 5 where it is used, are compared to the portable ones.
+// [[Rcpp::export]]
+Rcpp::List kernels_benchmark(int level, int repetitions) {
+  const SimdKernels& scalar = simdScalarKernels();
+  const SimdKernels& selected = simdKernels();
+  const double O[3] = {0.0, 0.0, 0.0};
+  const double A[3] = {1.0, 0.0, 0.0};
+  const double B[3] = {0.0, 1.0, 0.0};
+  const double C[3] = {0.0, 0.0, 1.0};
+  const int n = 1 << level;
+  const size_t npoints = gridSize(n);
+  std::vector<double> reference(3 * npoints), grid(3 * npoints);
+  double* x = grid.data();
+  double* y = x + npoints;
+  double* z = y + npoints;
+  const double tInline = meanSeconds(repetitions, [&]() {
+    subdivideGrid(n, A, B, C, 1.0, O, x, y, z);
+  });
+  const std::vector<double> inlined = grid;
+  const double tScalar = meanSeconds(repetitions, [&]() {
+    streamGrid(n, A, B, C, 1.0, O, x, y, z, scalar.sphericalMidpoints);
+  });
+  reference = grid;
+  const double tSelected = meanSeconds(repetitions, [&]() {
+    streamGrid(n, A, B, C, 1.0, O, x, y, z, selected.sphericalMidpoints);
+  });
+  bool midpointsEqual = grid == reference && inlined == reference;
+  // the subdivisions specialized at compile time
+  for(int l = 0; l <= 5; l++) {
+    const int m = 1 << l;
+    const size_t size = gridSize(m);
+    std::vector<double> specialized(3 * size), streamed(3 * size);
+    subdivideTriangle(
+      l, A, B, C, 1.0, O, specialized.data(), specialized.data() + size,
+      specialized.data() + 2 * size
+    );
+    streamGrid(
+      m, A, B, C, 1.0, O, streamed.data(), streamed.data() + size,
+      streamed.data() + 2 * size, scalar.sphericalMidpoints
+    );
+    midpointsEqual = midpointsEqual && specialized == streamed;
+  }
+  // vertex buffers of the grid
+  std::vector<double> xyz(3 * npoints);
+  for(size_t i = 0; i < npoints; i++) {
+    xyz[3*i]     = x[i];
+    xyz[3*i + 1] = y[i];
+    xyz[3*i + 2] = z[i];
+  }
+  std::vector<double> vbuffer(6 * npoints), vreference(6 * npoints);
+  const double tNormalsScalar = meanSeconds(repetitions, [&]() {
+    scalar.interleaveNormals(npoints, xyz.data(), O, vreference.data());
+  });
+  const double tNormalsSelected = meanSeconds(repetitions, [&]() {
+    selected.interleaveNormals(npoints, xyz.data(), O, vbuffer.data());
+  });
+  const bool normalsEqual = vbuffer == vreference;
+  return Rcpp::List::create(
+    Rcpp::Named("kernels") = selected.name,
+    Rcpp::Named("points")  = double(npoints),
+    Rcpp::Named("midpoints") = Rcpp::NumericVector::create(
+      Rcpp::Named("inline")   = tInline,
+      Rcpp::Named("scalar")   = tScalar,
+      Rcpp::Named("selected") = tSelected
+    ),
+    Rcpp::Named("normals") = Rcpp::NumericVector::create(
+      Rcpp::Named("scalar")   = tNormalsScalar,
+      Rcpp::Named("selected") = tNormalsSelected
+    ),
+    Rcpp::Named("identical") = midpointsEqual && normalsEqual
+  );
+}
@@ -1,39 +1,108 @@
 #include "sphereTessellation.h"
 
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// levels of detail of the mesh as a list whose l-th element has the fields
+// `nvertices`, the number of vertices of the mesh used by this level, and
+// `indices` and `ids`, as in the mesh, or `indices` and `offsets` if the mesh
+// is in the compact form; the finest level shares these fields with the mesh
+Rcpp::List pyramidToList(
+    const MeshPyramid& pyramid, int nfaces, bool compact, Rcpp::List Mesh,
+    int nthreads
+) {
+  const int nlevels = pyramid.nvertices.size();
+  const std::string field = compact ? "offsets" : "ids";
+  Rcpp::List Levels(nlevels);
+  for(int l = 0; l < nlevels - 1; l++) {
+    const std::vector<int>& faces = pyramid.faces[l];
+    const int m = 1 << l;
+    SEXP Indices;
+    if(compact) {
+      Indices = encodeIndices(faces.data(), faces.size(), 1, nthreads);
+    } else {
+      Rcpp::IntegerMatrix Triangles(3, faces.size() / 3);
+      for(size_t k = 0; k < faces.size(); k++) {
+        Triangles[k] = faces[k] + 1;
+      }
+      Indices = Triangles;
+    }
+    // the faces of the triangles, given by `ids` or by `offsets`
+    Rcpp::IntegerVector Faces(compact ? nfaces + 1 : faces.size() / 3);
+    if(compact) {
+      for(int f = 0; f <= nfaces; f++) {
+        Faces(f) = f * m * m;
+      }
+    } else {
+      for(int f = 0; f < nfaces; f++) {
+        std::fill(
+          Faces.begin() + f * m * m, Faces.begin() + (f + 1) * m * m, f + 1
+        );
+      }
+    }
+    Levels(l) = Rcpp::List::create(
+      Rcpp::Named("nvertices") = double(pyramid.nvertices[l]),
+      Rcpp::Named("indices")   = Indices,
+      Rcpp::Named(field)       = Faces
+    );
+  }
+  Levels(nlevels - 1) = Rcpp::List::create(
+    Rcpp::Named("nvertices") = double(pyramid.nvertices[nlevels - 1]),
+    Rcpp::Named("indices")   = Mesh["indices"],
+    Rcpp::Named(field)       = Mesh[field]
+  );
+  return Levels;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
 // [[Rcpp::export]]
 Rcpp::List delaunay_cpp(
-    Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter
+    Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter,
+    bool meshes, bool spatialsort, int nthreads, bool profiling = false,
+    double tolerance = 0, bool lod = false, bool parallel = false,
+    bool compact = false, bool metrics = false, double epsilon = 0
 ) {
-  const int npoints = pts.ncol();
-  std::vector<SPoint3> points;
-  points.reserve(npoints);
-  for(int i = 0; i < npoints; i++) {
-    Rcpp::NumericVector pt_i = pts(Rcpp::_, i);
-    points.emplace_back(pt_i(0), pt_i(1), pt_i(2));
-  }
+  Profile profile(profiling);
   // ball
   Traits ball(SPoint3(O(0), O(1), O(2)), radius);
-  // projection on this ball
-  Traits::Construct_point_on_sphere_2 projection =
-    ball.construct_point_on_sphere_2_object();
+  std::vector<PointOnSphere> spoints;
+  std::vector<SPoint3> projections;
+  projectPoints(ball, pts, spoints, projections);
+  // duplicated and close points, merged into the kept vertices
+  std::vector<int> mapping =
+    mergePoints(spoints, projections, ball.center(), radius, epsilon);
+  profile.stage("projection");
+  profile.count("mergedPoints", pts.ncol() - projections.size());
+  profile.count(
+    "bytes",
+    bufferBytes(spoints) + bufferBytes(projections) + bufferBytes(mapping)
+  );
+  // make Delaunay triangulation, given by the vertices of its faces, which
+  // are sorted in the same way by both constructions
+  std::vector<int> faces;
+  std::vector<char> ghosts;
+  const int dim = parallel
+    ? parallelDelaunay(
+        ball, spoints, projections, spatialsort, nthreads, mapping, faces,
+        ghosts
+      )
+    : serialDelaunay(
+        ball, spoints, projections, spatialsort, mapping, faces, ghosts
+      );
+  profile.stage("insertion");
+  profile.count("vertices", projections.size());
+  profile.count("bytes", bufferBytes(faces) + bufferBytes(ghosts));
   // Rcpp matrix to store the projected vertices
+  const int npoints = projections.size();
   Rcpp::NumericMatrix Vertices(3, npoints);
-  // make Delaunay triangulation
-  DToS dtos(ball);
-  {
-    int i = 0;
-    for(const auto& pt : points) {
-      Traits::Point_on_sphere_2 pos = projection(pt);
-      DToS::Vertex_handle vh = dtos.insert(pos);
-      SPoint3 p = pos.get_projection(ball.center(), ball.radius());
-      Rcpp::NumericVector v_i = {p.x(), p.y(), p.z()};
-      Vertices(Rcpp::_, i++) = v_i;
-      int& index = vh->info();
-      index = i;
-    }
+  for(int i = 0; i < npoints; i++) {
+    const SPoint3& p = projections[i];
+    Vertices(0, i) = p.x();
+    Vertices(1, i) = p.y();
+    Vertices(2, i) = p.z();
   }
+  profile.objects(Vertices);
   // check dimension
-  int dim = dtos.dimension();
   if(dim == -2) {
     Rcpp::stop("The triangulation is empty.");
   }
@@ -47,51 +116,172 @@ Rcpp::List delaunay_cpp(
     Rcpp::stop("The triangulation is just a polygon drawn on a circle.");
   }
   // messages
-  const int nsolidFaces = dtos.number_of_solid_faces();
-  const int nghostFaces = dtos.number_of_ghost_faces();
+  const int nfaces = ghosts.size();
+  const int nghostFaces = std::count(ghosts.begin(), ghosts.end(), true);
+  const int nsolidFaces = nfaces - nghostFaces;
   const std::string word1 = nsolidFaces > 1 ? "faces" : "face";
   const std::string word2 = nghostFaces > 1 ? "faces" : "face";
   const std::string msg =
     "The triangulation has " + std::to_string(nsolidFaces) + " solid " + word1
       + " and " + std::to_string(nghostFaces) + " ghost " + word2 + ".";
   Message(msg);
+  profile.count("solidFaces", nsolidFaces);
+  profile.count("ghostFaces", nghostFaces);
   // Rcpp matrix to store the faces
-  const int nfaces = dtos.number_of_faces();
   Rcpp::IntegerMatrix Faces(3, nfaces);
+  std::copy(faces.begin(), faces.end(), Faces.begin());
+  profile.objects(Faces);
   // Rcpp vector to store the indices of the solid faces
   Rcpp::IntegerVector SolidFaces(nsolidFaces);
-  // iterate over all faces
-  DToS::All_faces_iterator itbegin = dtos.all_faces_begin();
-  DToS::All_faces_iterator itend = dtos.all_faces_end();
-  int faceIndex = 0;
   int solidfaceIndex = 0;
-  for(auto f = itbegin; f != itend; f++) {
-    if(!f->is_ghost()) {
-      SolidFaces(solidfaceIndex++) = faceIndex + 1;
+  for(int f = 0; f < nfaces; f++) {
+    if(!ghosts[f]) {
+      SolidFaces(solidfaceIndex++) = f + 1;
     }
-    // make the face
-    Rcpp::IntegerVector Face = {
-      f->vertex(0)->info(),
-      f->vertex(1)->info(),
-      f->vertex(2)->info()
-    };
-    Faces(Rcpp::_, faceIndex++) = Face;
   }
-  // Meshes of spherical triangles
-  const int nmeshes = dtos.number_of_solid_faces();
-  Rcpp::List Meshes(nmeshes);
-  for(int i = 0; i < nmeshes; i++) {
-    const Rcpp::IntegerVector face = Faces(Rcpp::_, SolidFaces(i)-1);
-    const Rcpp::NumericVector A = Vertices(Rcpp::_, face(0)-1);
-    const Rcpp::NumericVector B = Vertices(Rcpp::_, face(1)-1);
-    const Rcpp::NumericVector C = Vertices(Rcpp::_, face(2)-1);
-    Meshes(i) = sTriangle(A, B, C, radius, O, niter);
+  profile.stage("faces");
+  // areas, perimeters, centroids and neighbors of the solid faces
+  const double center[3] = {O(0), O(1), O(2)};
+  Rcpp::List Metrics;
+  if(metrics) {
+    Metrics =
+      delaunayMetrics(projections, faces, ghosts, center, radius, nthreads);
+    profile.stage("metrics");
+  }
+  if(!meshes) {
+    Rcpp::List Delaunay = Rcpp::List::create(
+      Rcpp::Named("vertices")   = Rcpp::transpose(Vertices),
+      Rcpp::Named("faces")      = Rcpp::transpose(Faces),
+      Rcpp::Named("solidFaces") = SolidFaces,
+      Rcpp::Named("mapping")    = rowMapping(mapping)
+    );
+    if(metrics) {
+      Delaunay["metrics"] = Metrics;
+    }
+    profile.stage("conversion");
+    if(profiling) {
+      profile.objects(Delaunay);
+      Delaunay.attr("profile") = profile.toList();
+    }
+    return Delaunay;
+  }
+  // mesh of the spherical triangles, sharing the points on common edges
+  std::vector<double> vertices(3 * npoints);
+  for(int i = 0; i < npoints; i++) {
+    const SPoint3& p = projections[i];
+    vertices[3*i]     = p.x();
+    vertices[3*i + 1] = p.y();
+    vertices[3*i + 2] = p.z();
+  }
+  std::vector<int> solidFaces(3 * nsolidFaces);
+  for(int i = 0; i < nsolidFaces; i++) {
+    for(int k = 0; k < 3; k++) {
+      solidFaces[3*i + k] = Faces(k, SolidFaces(i) - 1) - 1;
+    }
+  }
+  const bool adaptive = tolerance > 0;
+  if(!adaptive && niter - 1 > maxMeshLevel) {
+    Rcpp::stop("The mesh is too large; reduce the number of iterations.");
   }
-  //
-  return Rcpp::List::create(
+  lod = lod && !adaptive;
+  MeshTopology topology;
+  edgeTopology(solidFaces, topology);
+  profile.count(
+    "bytes",
+    bufferBytes(vertices) + bufferBytes(solidFaces) + bufferBytes(topology)
+  );
+  Rcpp::List Mesh;
+  if(lod) {
+    // the levels of detail renumber the vertices of the mesh, which is
+    // therefore built before being converted
+    SMesh smesh =
+      subdivideMesh(vertices, solidFaces, niter - 1, radius, center, nthreads);
+    profile.stage("subdivision");
+    MeshPyramid pyramid;
+    meshPyramid(
+      npoints, solidFaces, topology, niter - 1, nthreads, smesh, pyramid
+    );
+    profile.stage("levels");
+    profile.count("meshVertices", smesh.vertices.size() / 3);
+    profile.count("meshTriangles", smesh.faces.size() / 3);
+    profile.count("bytes", bufferBytes(smesh) + bufferBytes(pyramid));
+    Mesh = compact
+      ? SMeshToCompactList(smesh, nthreads) : SMeshToList(smesh, center);
+    Mesh["levels"] =
+      pyramidToList(pyramid, nsolidFaces, compact, Mesh, nthreads);
+  } else {
+    // the size of the mesh is known in closed form, or from the levels of the
+    // adaptive subdivision, so the faces are subdivided directly in the
+    // buffers of the R mesh
+    AdaptiveLayout layout;
+    size_t nmeshVertices, nmeshTriangles;
+    if(adaptive) {
+      FaceScratch scratch;
+      adaptiveLayout(
+        vertices.data(), npoints, solidFaces, topology, radius, center,
+        tolerance, nthreads, scratch, layout
+      );
+      nmeshVertices = layout.interiorPoints[nsolidFaces];
+      nmeshTriangles = layout.triangles[nsolidFaces];
+      profile.count("bytes", bufferBytes(layout) + bufferBytes(scratch));
+    } else {
+      meshSize(
+        npoints, topology.nedges, nsolidFaces, niter - 1, nmeshVertices,
+        nmeshTriangles
+      );
+    }
+    if(nmeshVertices > size_t(INT_MAX) ||
+       3 * nmeshTriangles > size_t(INT_MAX)) {
+      Rcpp::stop("The mesh is too large; reduce the number of iterations.");
+    }
+    Rcpp::NumericMatrix MeshVertices(
+      compact ? 0 : 6, compact ? 0 : nmeshVertices
+    );
+    Rcpp::RawVector MeshPositions(
+      compact ? 3 * sizeof(float) * nmeshVertices : 0
+    );
+    // in the compact form, the indices are encoded once they are all known
+    Rcpp::IntegerMatrix MeshIndices(3, compact ? 0 : nmeshTriangles);
+    std::vector<int> indices(compact ? 3 * nmeshTriangles : 0);
+    Rcpp::IntegerVector MeshIds(compact ? 0 : nmeshTriangles);
+    Rcpp::IntegerVector MeshOffsets(compact ? nsolidFaces + 1 : 0);
+    const PackedMesh packed = {
+      compact ? nullptr : MeshVertices.begin(),
+      reinterpret_cast<float*>(MeshPositions.begin()),
+      compact ? indices.data() : MeshIndices.begin(),
+      compact ? nullptr : MeshIds.begin(),
+      compact ? MeshOffsets.begin() : nullptr
+    };
+    const size_t scratchBytes = subdividePacked(
+      vertices, solidFaces, topology, niter - 1, adaptive ? &layout : nullptr,
+      radius, center, nthreads, packed
+    );
+    profile.stage("subdivision");
+    profile.count("meshVertices", nmeshVertices);
+    profile.count("meshTriangles", nmeshTriangles);
+    profile.count("bytes", bufferBytes(indices) + scratchBytes);
+    Mesh = compact
+      ? compactMesh(
+          MeshPositions,
+          encodeIndices(indices.data(), indices.size(), 0, nthreads),
+          MeshOffsets
+        )
+      : renderMesh(MeshVertices, MeshIndices, MeshIds);
+  }
+  Rcpp::List Delaunay = Rcpp::List::create(
     Rcpp::Named("vertices")   = Rcpp::transpose(Vertices),
     Rcpp::Named("faces")      = Rcpp::transpose(Faces),
     Rcpp::Named("solidFaces") = SolidFaces,
-    Rcpp::Named("meshes")     = Meshes
+    Rcpp::Named("mesh")       = Mesh,
+    Rcpp::Named("mapping")    = rowMapping(mapping)
   );
+  if(metrics) {
+    Delaunay["metrics"] = Metrics;
+  }
+  profile.stage("conversion");
+  if(profiling) {
+    profile.objects(Delaunay);
+    Delaunay.attr("profile") = profile.toList();
+  }
+  return Delaunay;
 }
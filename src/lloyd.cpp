@@ -0,0 +1,260 @@
+#include "sphereTessellation.h"
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// unit vector of a vertex of the triangulation
+inline void vertexUnit(
+    const DToS::Vertex_handle v, const SPoint3& O, double radius, double* u
+) {
+  const SPoint3 p = v->point().get_projection(O, radius);
+  u[0] = p.x() - O.x();
+  u[1] = p.y() - O.y();
+  u[2] = p.z() - O.z();
+  const double norm = sqrt(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]);
+  u[0] /= norm;
+  u[1] /= norm;
+  u[2] /= norm;
+}
+
+// whether the triangle abc (unit vectors) is counterclockwise and the unit
+// vector d is outside its circumcircle, both with a margin far above the
+// rounding errors, so that the exact predicates of CGAL agree
+bool safeDelaunay(
+    const double* a, const double* b, const double* c, const double* d
+) {
+  const double orientation = a[0] * (b[1]*c[2] - b[2]*c[1])
+    - a[1] * (b[0]*c[2] - b[2]*c[0]) + a[2] * (b[0]*c[1] - b[1]*c[0]);
+  const double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  const double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+  const double w[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+  const double uu = u[0]*u[0] + u[1]*u[1] + u[2]*u[2];
+  const double vv = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+  const double ww = w[0]*w[0] + w[1]*w[1] + w[2]*w[2];
+  // the point d is inside the circle when it is on the outer side of the
+  // plane of the circle
+  const double det = u[0] * (v[1]*w[2] - v[2]*w[1])
+    - u[1] * (v[0]*w[2] - v[2]*w[0]) + u[2] * (v[0]*w[1] - v[1]*w[0]);
+  return orientation > 1e-10 * sqrt(uu * vv) &&
+    det < -1e-10 * sqrt(uu * vv * ww);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Spherical centroids of the Voronoï cells of the vertices `vhs`, as unit
+// vectors, the infos of the faces being set by indexFaces; returns the
+// largest angle between a site and the centroid of its cell.
+double voronoiCentroids(
+    const DToS& dtos, const std::vector<DToS::Vertex_handle>& vhs,
+    const std::vector<double>& vvertices, int nthreads,
+    std::vector<double>& centroids
+) {
+  const Traits& ball = dtos.geom_traits();
+  const SPoint3 O = ball.center();
+  const double radius = ball.radius();
+  const int nsites = vhs.size();
+  std::vector<double> angles(nsites);
+  parallelFor(nsites, nthreads, [&](int begin, int end, int) {
+    std::vector<double> units;
+    for(int k = begin; k < end; k++) {
+      units.clear();
+      const DToS::Face_circulator done = dtos.incident_faces(vhs[k]);
+      DToS::Face_circulator fc = done;
+      do {
+        const double* p = &vvertices[3 * fc->info()];
+        units.insert(units.end(), {
+          (p[0] - O.x()) / radius, (p[1] - O.y()) / radius,
+          (p[2] - O.z()) / radius
+        });
+      } while(++fc != done);
+      double s[3], area, perimeter;
+      double* c = &centroids[3*k];
+      vertexUnit(vhs[k], O, radius, s);
+      polygonMetrics(units.data(), units.size() / 3, s, area, perimeter, c);
+      const double norm = sqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]);
+      if(norm == 0) {
+        std::copy(s, s + 3, c);
+      } else {
+        c[0] /= norm;
+        c[1] /= norm;
+        c[2] /= norm;
+      }
+      const double cross[3] = {
+        s[1]*c[2] - s[2]*c[1], s[2]*c[0] - s[0]*c[2], s[0]*c[1] - s[1]*c[0]
+      };
+      angles[k] = atan2(
+        sqrt(cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]),
+        s[0]*c[0] + s[1]*c[1] + s[2]*c[2]
+      );
+    }
+  });
+  return nsites > 0 ? *std::max_element(angles.begin(), angles.end()) : 0;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Moves each vertex vhs[k] to the unit vector targets[3k, 3k+1, 3k+2]. The
+// points of the vertices are changed in place as long as the faces around the
+// moved vertices remain counterclockwise and locally Delaunay, which is
+// checked in parallel; the vertices for which this fails get back their
+// points, until all checks pass, and then they are removed and inserted at
+// their targets, unless a target is too close to another vertex. Updates
+// `vhs` and returns the number of reinserted vertices.
+int moveVertices(
+    DToS& dtos, std::vector<DToS::Vertex_handle>& vhs,
+    const std::vector<double>& targets, int nthreads
+) {
+  const Traits& ball = dtos.geom_traits();
+  const SPoint3 O = ball.center();
+  const double radius = ball.radius();
+  Traits::Construct_point_on_sphere_2 projection =
+    ball.construct_point_on_sphere_2_object();
+  const int nsites = vhs.size();
+  std::vector<PointOnSphere> previous(nsites), destinations(nsites);
+  std::vector<double> units(3 * nsites);
+  std::vector<char> moved(nsites, 1);
+  for(int k = 0; k < nsites; k++) {
+    const double* t = &targets[3*k];
+    previous[k] = vhs[k]->point();
+    destinations[k] = projection(SPoint3(
+      O.x() + radius * t[0], O.y() + radius * t[1], O.z() + radius * t[2]
+    ));
+    vhs[k]->set_point(destinations[k]);
+    std::copy(t, t + 3, &units[3*k]);
+  }
+  // the infos of the vertices are their one-based indices in `vhs`
+  std::vector<DToS::Face_handle> fhs;
+  fhs.reserve(dtos.number_of_faces());
+  for(auto f = dtos.all_faces_begin(); f != dtos.all_faces_end(); f++) {
+    fhs.push_back(f);
+  }
+  const int nfaces = fhs.size();
+  std::vector<char> failed(nfaces);
+  for(;;) {
+    parallelFor(nfaces, nthreads, [&](int begin, int end, int) {
+      for(int f = begin; f < end; f++) {
+        const DToS::Face_handle fh = fhs[f];
+        int ids[6];
+        bool touched = false;
+        for(int i = 0; i < 3; i++) {
+          ids[i] = fh->vertex(i)->info() - 1;
+          const DToS::Face_handle g = fh->neighbor(i);
+          ids[3 + i] = g->vertex(g->index(fh))->info() - 1;
+        }
+        for(int i = 0; i < 6; i++) {
+          touched = touched || moved[ids[i]];
+        }
+        failed[f] = false;
+        for(int i = 0; touched && i < 3 && !failed[f]; i++) {
+          const double* a = &units[3 * ids[i]];
+          const double* b = &units[3 * ids[dtos.ccw(i)]];
+          const double* c = &units[3 * ids[dtos.cw(i)]];
+          failed[f] = !safeDelaunay(a, b, c, &units[3 * ids[3 + i]]);
+        }
+      }
+    });
+    // the moved vertices of the failed faces and of their neighbors
+    std::vector<int> unsafe;
+    for(int f = 0; f < nfaces; f++) {
+      if(failed[f]) {
+        for(int i = 0; i < 3; i++) {
+          const DToS::Face_handle g = fhs[f]->neighbor(i);
+          unsafe.push_back(fhs[f]->vertex(i)->info() - 1);
+          unsafe.push_back(g->vertex(g->index(fhs[f]))->info() - 1);
+        }
+      }
+    }
+    bool reverted = false;
+    for(const int k : unsafe) {
+      if(moved[k]) {
+        moved[k] = 0;
+        vhs[k]->set_point(previous[k]);
+        vertexUnit(vhs[k], O, radius, &units[3*k]);
+        reverted = true;
+      }
+    }
+    if(!reverted) {
+      break;
+    }
+  }
+  // the triangulation is valid again; the other vertices are reinserted
+  int nreinserted = 0;
+  for(int k = 0; k < nsites; k++) {
+    if(moved[k]) {
+      continue;
+    }
+    const DToS::Vertex_handle v = vhs[k];
+    DToS::Locate_type lt;
+    int li;
+    dtos.locate(destinations[k], lt, li, v->face());
+    if(lt == DToS::VERTEX || lt == DToS::TOO_CLOSE) {
+      continue;
+    }
+    const DToS::Vertex_handle w = dtos.incident_vertices(v);
+    dtos.remove(v);
+    const DToS::Vertex_handle vh = dtos.insert(destinations[k], w->face());
+    vh->info() = k + 1;
+    vhs[k] = vh;
+    nreinserted++;
+  }
+  return nreinserted;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Lloyd relaxation: the sites are moved to the spherical centroids of their
+// Voronoï cells until they move by less than `tolerance` or `niter`
+// iterations are done; one triangulation is kept along the iterations.
+// [[Rcpp::export]]
+Rcpp::List lloyd_cpp(
+    Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter,
+    double tolerance, bool spatialsort, int nthreads
+) {
+  Traits ball(SPoint3(O(0), O(1), O(2)), radius);
+  DToS dtos(ball);
+  std::vector<PointOnSphere> spoints;
+  std::vector<SPoint3> projections;
+  projectPoints(ball, pts, spoints, projections);
+  std::vector<DToS::Vertex_handle> vhs =
+    insertPoints(dtos, spoints, projections, spatialsort, 1);
+  const int nsites = vhs.size();
+  if(int(dtos.number_of_vertices()) != nsites) {
+    Rcpp::stop("Some vertices are too close to each other.");
+  }
+  if(dtos.dimension() != 2 || dtos.number_of_ghost_faces() != 0) {
+    Rcpp::stop("The Delaunay triangulation has some ghost faces.");
+  }
+  std::vector<double> centroids(3 * nsites);
+  double displacement = 0;
+  int iteration = 0, nreinserted = 0;
+  bool converged = false;
+  for(;;) {
+    const std::vector<DToS::Face_handle> fhs = indexFaces(dtos);
+    const std::vector<double> vvertices = voronoiVertices(dtos, fhs, nthreads);
+    displacement =
+      radius * voronoiCentroids(dtos, vhs, vvertices, nthreads, centroids);
+    converged = displacement <= tolerance;
+    if(converged || iteration == niter) {
+      break;
+    }
+    nreinserted += moveVertices(dtos, vhs, centroids, nthreads);
+    if(dtos.number_of_ghost_faces() != 0) {
+      Rcpp::stop("The Delaunay triangulation has some ghost faces.");
+    }
+    iteration++;
+    Rcpp::checkUserInterrupt();
+  }
+  Rcpp::NumericMatrix Sites(nsites, 3);
+  for(int k = 0; k < nsites; k++) {
+    const SPoint3 site = vhs[k]->point().get_projection(ball.center(), radius);
+    Sites(k, 0) = site.x();
+    Sites(k, 1) = site.y();
+    Sites(k, 2) = site.z();
+  }
+  return Rcpp::List::create(
+    Rcpp::Named("sites")        = Sites,
+    Rcpp::Named("iterations")   = iteration,
+    Rcpp::Named("displacement") = displacement,
+    Rcpp::Named("converged")    = converged,
+    Rcpp::Named("reinsertions") = nreinserted
+  );
+}
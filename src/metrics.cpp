@@ -0,0 +1,201 @@
+#include "sphereTessellation.h"
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// angle between two unit vectors
+inline double unitAngle(const double* u, const double* v) {
+  const double cx = u[1]*v[2] - u[2]*v[1];
+  const double cy = u[2]*v[0] - u[0]*v[2];
+  const double cz = u[0]*v[1] - u[1]*v[0];
+  return atan2(
+    sqrt(cx*cx + cy*cy + cz*cz), u[0]*v[0] + u[1]*v[1] + u[2]*v[2]
+  );
+}
+
+// spherical excess of the triangle abc (unit vectors, counterclockwise), by
+// the formula of Van Oosterom and Strackee:
+// tan(E/2) = det(a, b, c) / (1 + a.b + b.c + c.a)
+inline double sphericalExcess(
+    const double* a, const double* b, const double* c
+) {
+  const double det = a[0] * (b[1]*c[2] - b[2]*c[1])
+    - a[1] * (b[0]*c[2] - b[2]*c[0]) + a[2] * (b[0]*c[1] - b[1]*c[0]);
+  const double ab = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+  const double bc = b[0]*c[0] + b[1]*c[1] + b[2]*c[2];
+  const double ca = c[0]*a[0] + c[1]*a[1] + c[2]*a[2];
+  return 2.0 * atan2(det, 1.0 + ab + bc + ca);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Metrics of a polygon of the unit sphere whose vertices are in
+// counterclockwise order seen from outside and which is star-shaped with
+// respect to the unit vector s: its area, the sum of the spherical excesses
+// of the triangles (s, v_i, v_i+1), its perimeter, and the integral of the
+// position over the polygon, that is the half sum over the sides of their
+// angles times the unit normals of their great circles, whose direction is
+// the spherical centroid of the polygon.
+void polygonMetrics(
+    const double* units, int nvertices, const double* s, double& area,
+    double& perimeter, double moment[3]
+) {
+  area = perimeter = 0;
+  moment[0] = moment[1] = moment[2] = 0;
+  for(int i = 0; i < nvertices; i++) {
+    const double* u = &units[3*i];
+    const double* v = &units[3 * ((i + 1) % nvertices)];
+    area += sphericalExcess(s, u, v);
+    const double angle = unitAngle(u, v);
+    perimeter += angle;
+    const double n[3] = {
+      u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0]
+    };
+    const double norm = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    if(norm > 0) {
+      for(int j = 0; j < 3; j++) {
+        moment[j] += 0.5 * angle * n[j] / norm;
+      }
+    }
+  }
+}
+
+// unit vector of a point of the sphere
+inline void unitVector(
+    const double* p, const double* O, double radius, double* u
+) {
+  u[0] = (p[0] - O[0]) / radius;
+  u[1] = (p[1] - O[1]) / radius;
+  u[2] = (p[2] - O[2]) / radius;
+}
+
+// point of the sphere in the direction of `moment`
+inline void centroid(
+    const double* moment, const double* O, double radius, double* c
+) {
+  const double norm = sqrt(
+    moment[0]*moment[0] + moment[1]*moment[1] + moment[2]*moment[2]
+  );
+  for(int j = 0; j < 3; j++) {
+    c[j] = norm > 0 ? O[j] + radius * moment[j] / norm : NA_REAL;
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// metrics of the Voronoï cells: `area`, `perimeter`, `centroid` (matrix with
+// one row per cell), and the adjacency in the flat form of `offsets` and
+// `neighbors`, as in the output of voronoi_cpp with `meshes = false`; the
+// sites are given by their coordinates
+Rcpp::List voronoiMetrics(
+    const std::vector<double>& vvertices, const VoronoiTopology& topology,
+    const std::vector<double>& sites, const double* O, double radius,
+    int nthreads
+) {
+  const std::vector<int>& offsets = topology.offsets;
+  const int ncells = offsets.size() - 1;
+  std::vector<double> areas(ncells), perimeters(ncells), centroids(3 * ncells);
+  parallelFor(ncells, nthreads, [&](int begin, int end, int) {
+    std::vector<double> units;
+    for(int k = begin; k < end; k++) {
+      const int cellsize = offsets[k + 1] - offsets[k];
+      units.resize(3 * cellsize);
+      for(int i = 0; i < cellsize; i++) {
+        unitVector(
+          &vvertices[3 * topology.cells[offsets[k] + i]], O, radius,
+          &units[3*i]
+        );
+      }
+      double s[3], moment[3];
+      unitVector(&sites[3*k], O, radius, s);
+      polygonMetrics(
+        units.data(), cellsize, s, areas[k], perimeters[k], moment
+      );
+      areas[k] *= radius * radius;
+      perimeters[k] *= radius;
+      centroid(moment, O, radius, &centroids[3*k]);
+    }
+  });
+  Rcpp::NumericMatrix Centroids(ncells, 3);
+  for(int k = 0; k < ncells; k++) {
+    for(int j = 0; j < 3; j++) {
+      Centroids(k, j) = centroids[3*k + j];
+    }
+  }
+  return Rcpp::List::create(
+    Rcpp::Named("area")      = Rcpp::wrap(areas),
+    Rcpp::Named("perimeter") = Rcpp::wrap(perimeters),
+    Rcpp::Named("centroid")  = Centroids,
+    Rcpp::Named("offsets")   = Rcpp::wrap(offsets),
+    Rcpp::Named("neighbors") = Rcpp::wrap(topology.neighbors)
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// metrics of the solid faces of a Delaunay triangulation given by the
+// one-based indices of their vertices: `area`, `perimeter`, `centroid`, and
+// `neighbors`, the matrix whose (k, s) entry is the index in the solid faces
+// of the face sharing the s-th side (AB, BC, CA) of the k-th solid face, NA
+// if it is a ghost face
+Rcpp::List delaunayMetrics(
+    const std::vector<SPoint3>& projections, const std::vector<int>& faces,
+    const std::vector<char>& ghosts, const double* O, double radius,
+    int nthreads
+) {
+  std::vector<int> solidFaces;
+  for(size_t f = 0; f < ghosts.size(); f++) {
+    if(!ghosts[f]) {
+      solidFaces.insert(solidFaces.end(), &faces[3*f], &faces[3*f] + 3);
+    }
+  }
+  const int nfaces = solidFaces.size() / 3;
+  std::vector<double> areas(nfaces), perimeters(nfaces), centroids(3 * nfaces);
+  parallelFor(nfaces, nthreads, [&](int begin, int end, int) {
+    for(int k = begin; k < end; k++) {
+      double units[9], moment[3];
+      for(int i = 0; i < 3; i++) {
+        const SPoint3& p = projections[solidFaces[3*k + i] - 1];
+        const double xyz[3] = {p.x(), p.y(), p.z()};
+        unitVector(xyz, O, radius, &units[3*i]);
+      }
+      polygonMetrics(units, 3, units, areas[k], perimeters[k], moment);
+      areas[k] *= radius * radius;
+      perimeters[k] *= radius;
+      centroid(moment, O, radius, &centroids[3*k]);
+    }
+  });
+  // the two sides of an edge are consecutive once sorted by their vertices
+  std::vector<std::pair<std::pair<int, int>, int>> sides(3 * nfaces);
+  for(int k = 0; k < nfaces; k++) {
+    for(int s = 0; s < 3; s++) {
+      const int a = solidFaces[3*k + s];
+      const int b = solidFaces[3*k + (s + 1) % 3];
+      sides[3*k + s] = std::make_pair(
+        std::make_pair(std::min(a, b), std::max(a, b)), 3*k + s
+      );
+    }
+  }
+  std::sort(sides.begin(), sides.end());
+  Rcpp::IntegerMatrix Neighbors(nfaces, 3);
+  std::fill(Neighbors.begin(), Neighbors.end(), NA_INTEGER);
+  for(size_t i = 0; i + 1 < sides.size(); i++) {
+    if(sides[i].first == sides[i + 1].first) {
+      const int side1 = sides[i].second, side2 = sides[i + 1].second;
+      Neighbors(side1 / 3, side1 % 3) = side2 / 3 + 1;
+      Neighbors(side2 / 3, side2 % 3) = side1 / 3 + 1;
+      i++;
+    }
+  }
+  Rcpp::NumericMatrix Centroids(nfaces, 3);
+  for(int k = 0; k < nfaces; k++) {
+    for(int j = 0; j < 3; j++) {
+      Centroids(k, j) = centroids[3*k + j];
+    }
+  }
+  return Rcpp::List::create(
+    Rcpp::Named("area")      = Rcpp::wrap(areas),
+    Rcpp::Named("perimeter") = Rcpp::wrap(perimeters),
+    Rcpp::Named("centroid")  = Centroids,
+    Rcpp::Named("neighbors") = Neighbors
+  );
+}
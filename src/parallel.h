@@ -0,0 +1,65 @@
+#ifndef __PARALLEL_HEADER__
+#define __PARALLEL_HEADER__
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Calls f(begin, end, thread) on chunks of [0, n) with at most `nthreads`
+// threads, the calling thread being one of them; `thread` is the index of the
+// running thread, lower than `nthreads`, so that f can use a scratch space per
+// thread. The chunks are dispatched dynamically. If f throws, the first
+// exception is rethrown in the calling thread once all threads have stopped.
+// f must not touch any R object.
+template <typename F>
+void parallelFor(int n, int nthreads, F f, int chunksize = 0) {
+  nthreads = std::max(1, std::min(nthreads, n));
+  if(nthreads == 1) {
+    if(n > 0) {
+      f(0, n, 0);
+    }
+    return;
+  }
+  if(chunksize <= 0) {
+    chunksize = std::max(1, n / (8 * nthreads));
+  }
+  std::atomic<int> next(0);
+  std::exception_ptr error;
+  std::mutex mutex;
+  auto worker = [&](int thread) {
+    try {
+      for(;;) {
+        const int begin = next.fetch_add(chunksize);
+        if(begin >= n) {
+          break;
+        }
+        f(begin, std::min(begin + chunksize, n), thread);
+      }
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(!error) {
+        error = std::current_exception();
+      }
+      next = n;
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(nthreads - 1);
+  for(int t = 1; t < nthreads; t++) {
+    threads.emplace_back(worker, t);
+  }
+  worker(0);
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+  if(error) {
+    std::rethrow_exception(error);
+  }
+}
+
+#endif
@@ -0,0 +1,361 @@
+#include "sphereTessellation.h"
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Parallel construction of the Delaunay triangulation. The points sorted
+// along a Hilbert curve are split into regions of consecutive points, and the
+// cube enclosing the sphere into a grid of 2^level cells along each axis,
+// each cell being a range of the sorted points since the keys of its points
+// share their first 3*level bits. A region is triangulated with the points of
+// its cells and of the neighboring cells. The circumscribed cap of a face of
+// this local triangulation only contains some points at a distance from its
+// vertices lower than its diameter; when this diameter is lower than the
+// width of a cell, these points belong to the local triangulation, which has
+// none of them in the cap, so the face is a face of the whole triangulation.
+// When all faces around the points of the region are certified in this way,
+// they form the stars of these points in the whole triangulation, and the
+// region keeps the faces whose smallest vertex is one of its points;
+// otherwise it is triangulated again with coarser cells. The Delaunay
+// triangulation is unique when no four points are cocircular, and the
+// construction falls back to the serial one in the other cases, as well as
+// when two points are too close to be both inserted or when the
+// triangulation has some ghost faces.
+
+// number of bits of the coordinates of the grid of the Hilbert keys
+const int hilbertBits = 21;
+
+// the parallel construction is used for this number of points or more
+const int minParallelPoints = 10000;
+
+// one-based indices of the vertices of the faces of a triangulation and
+// whether they are ghost faces, in the iteration order of the faces
+void triangulationFaces(
+    const DToS& dtos, std::vector<int>& faces, std::vector<char>& ghosts
+) {
+  faces.clear();
+  ghosts.clear();
+  faces.reserve(3 * dtos.number_of_faces());
+  ghosts.reserve(dtos.number_of_faces());
+  for(auto f = dtos.all_faces_begin(); f != dtos.all_faces_end(); f++) {
+    for(int k = 0; k < 3; k++) {
+      faces.push_back(f->vertex(k)->info());
+    }
+    ghosts.push_back(f->is_ghost());
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Sorts the faces in the lexicographic order of their vertices, each face
+// starting with its smallest vertex (the orientation is kept), by a counting
+// sort on the smallest vertex; `nvertices` is the largest vertex index.
+void sortFaces(
+    std::vector<int>& faces, std::vector<char>& ghosts, int nvertices
+) {
+  const size_t nfaces = ghosts.size();
+  for(size_t f = 0; f < nfaces; f++) {
+    int* face = &faces[3*f];
+    const int k = face[1] < face[0]
+      ? (face[2] < face[1] ? 2 : 1) : (face[2] < face[0] ? 2 : 0);
+    std::rotate(face, face + k, face + 3);
+  }
+  std::vector<size_t> starts(nvertices + 2, 0);
+  for(size_t f = 0; f < nfaces; f++) {
+    starts[faces[3*f] + 1]++;
+  }
+  for(int v = 1; v <= nvertices + 1; v++) {
+    starts[v] += starts[v - 1];
+  }
+  std::vector<size_t> order(nfaces);
+  for(size_t f = 0; f < nfaces; f++) {
+    order[starts[faces[3*f]]++] = f;
+  }
+  // `starts[v]` is now the end of the faces starting with v
+  size_t begin = 0;
+  for(int v = 0; v <= nvertices; v++) {
+    std::sort(
+      order.begin() + begin, order.begin() + starts[v],
+      [&faces](size_t f1, size_t f2) {
+        return faces[3*f1 + 1] < faces[3*f2 + 1] ||
+          (faces[3*f1 + 1] == faces[3*f2 + 1] &&
+            faces[3*f1 + 2] < faces[3*f2 + 2]);
+      }
+    );
+    begin = starts[v];
+  }
+  std::vector<int> sortedFaces(3 * nfaces);
+  std::vector<char> sortedGhosts(nfaces);
+  for(size_t f = 0; f < nfaces; f++) {
+    std::copy(&faces[3*order[f]], &faces[3*order[f]] + 3, &sortedFaces[3*f]);
+    sortedGhosts[f] = ghosts[order[f]];
+  }
+  faces.swap(sortedFaces);
+  ghosts.swap(sortedGhosts);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Serial construction of the Delaunay triangulation, whose faces are sorted
+// by sortFaces as the ones of the parallel construction: the points found
+// equal by CGAL are merged by mergeVertices, which updates `projections` and
+// `mapping`; returns the dimension of the triangulation.
+int serialDelaunay(
+    const Traits& ball, const std::vector<PointOnSphere>& spoints,
+    std::vector<SPoint3>& projections, bool spatialsort,
+    std::vector<int>& mapping, std::vector<int>& faces,
+    std::vector<char>& ghosts
+) {
+  DToS dtos(ball);
+  const std::vector<DToS::Vertex_handle> vhs =
+    insertPoints(dtos, spoints, projections, spatialsort, 1);
+  mergeVertices(dtos, vhs, spoints, projections, mapping);
+  if(dtos.dimension() == 2) {
+    triangulationFaces(dtos, faces, ghosts);
+    sortFaces(faces, ghosts, projections.size());
+  }
+  return dtos.dimension();
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// range of the sorted keys in the cell of coordinates C at `level`
+std::pair<int, int> cellRange(
+    const std::vector<std::pair<uint64_t, int>>& keys, const uint32_t C[3],
+    int level
+) {
+  const int shift = hilbertBits - level;
+  uint32_t X[3] = {C[0] << shift, C[1] << shift, C[2] << shift};
+  const uint64_t first = (hilbertKey(X) >> (3 * shift)) << (3 * shift);
+  const uint64_t last = first + (uint64_t(1) << (3 * shift));
+  const auto before = [](const std::pair<uint64_t, int>& key, uint64_t k) {
+    return key.first < k;
+  };
+  const auto begin =
+    std::lower_bound(keys.begin(), keys.end(), first, before);
+  const auto end = std::lower_bound(begin, keys.end(), last, before);
+  return std::make_pair(int(begin - keys.begin()), int(end - keys.begin()));
+}
+
+// whether the circumscribed cap of the spherical triangle abc (unit vectors,
+// counterclockwise) has a diameter lower than `width`
+bool smallCap(
+    const double* a, const double* b, const double* c, double width
+) {
+  const double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  const double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+  const double n[3] = {
+    u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0]
+  };
+  const double n2 = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+  const double dot = n[0]*a[0] + n[1]*a[1] + n[2]*a[2];
+  if(n2 == 0 || dot <= 0) {
+    return false;
+  }
+  // the cap has angular radius t, cos(t) = dot / |n|, and its chords are at
+  // most 2 * sin(t) long
+  const double sin2 = 1.0 - dot * dot / n2;
+  return 4.0 * sin2 < width * width * (1.0 - 1e-6);
+}
+
+// whether the point d is on the circle of the unit vectors a, b, c, up to
+// the rounding errors
+bool cocircular(
+    const double* a, const double* b, const double* c, const double* d
+) {
+  const double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  const double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+  const double w[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+  const double det = u[0] * (v[1]*w[2] - v[2]*w[1])
+    - u[1] * (v[0]*w[2] - v[2]*w[0]) + u[2] * (v[0]*w[1] - v[1]*w[0]);
+  const double scale = sqrt(
+    (u[0]*u[0] + u[1]*u[1] + u[2]*u[2]) * (v[0]*v[0] + v[1]*v[1] + v[2]*v[2])
+      * (w[0]*w[0] + w[1]*w[1] + w[2]*w[2])
+  );
+  return fabs(det) <= 1e-12 * scale;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Triangulates the region [begin, end) of the sorted points with the points
+// of the neighboring cells at `level`. Returns true and sets the faces of the
+// region if all faces around its points are certified; sets `fallback` if
+// the construction must be serial.
+bool triangulateRegion(
+    const Traits& ball, const std::vector<PointOnSphere>& spoints,
+    const std::vector<std::pair<uint64_t, int>>& keys,
+    const std::vector<int>& ranks, const std::vector<double>& units,
+    const std::vector<uint32_t>& coordinates, int begin, int end, int level,
+    std::atomic<bool>& fallback, std::vector<int>& faces
+) {
+  const int shift = hilbertBits - level;
+  const uint32_t ncells = 1u << level;
+  // ranges of the points of the cells of the region and of their neighbors
+  std::vector<std::pair<int, int>> ranges;
+  uint32_t previous[3] = {ncells, ncells, ncells};
+  for(int k = begin; k < end; k++) {
+    const uint32_t* X = &coordinates[3 * keys[k].second];
+    const uint32_t cell[3] = {X[0] >> shift, X[1] >> shift, X[2] >> shift};
+    if(std::equal(cell, cell + 3, previous)) {
+      continue;
+    }
+    std::copy(cell, cell + 3, previous);
+    for(int offset = 0; offset < 27; offset++) {
+      const uint32_t C[3] = {
+        cell[0] + offset % 3 - 1, cell[1] + offset / 3 % 3 - 1,
+        cell[2] + offset / 9 - 1
+      };
+      if(C[0] >= ncells || C[1] >= ncells || C[2] >= ncells) {
+        continue;
+      }
+      const std::pair<int, int> range = cellRange(keys, C, level);
+      if(range.first < range.second) {
+        ranges.push_back(range);
+      }
+    }
+  }
+  std::sort(ranges.begin(), ranges.end());
+  // local triangulation, the points being inserted along the Hilbert curve
+  DToS dtos(ball);
+  DToS::Face_handle hint;
+  int last = 0;
+  for(const std::pair<int, int>& range : ranges) {
+    for(int k = std::max(range.first, last); k < range.second; k++) {
+      const int i = keys[k].second;
+      const size_t nvertices = dtos.number_of_vertices();
+      const DToS::Vertex_handle vh = dtos.insert(spoints[i], hint);
+      if(vh == DToS::Vertex_handle() ||
+          dtos.number_of_vertices() == nvertices) {
+        fallback = true;
+        return false;
+      }
+      vh->info() = i + 1;
+      if(dtos.dimension() == 2) {
+        hint = vh->face();
+      }
+    }
+    last = std::max(last, range.second);
+  }
+  if(dtos.dimension() != 2) {
+    return false;
+  }
+  const auto inRegion = [&](int info) {
+    const int rank = ranks[info - 1];
+    return rank >= begin && rank < end;
+  };
+  const auto unit = [&](const DToS::Vertex_handle v) {
+    return &units[3 * (v->info() - 1)];
+  };
+  const double width = 2.0 / double(ncells);
+  faces.clear();
+  for(auto f = dtos.all_faces_begin(); f != dtos.all_faces_end(); f++) {
+    const int face[3] = {
+      f->vertex(0)->info(), f->vertex(1)->info(), f->vertex(2)->info()
+    };
+    if(!inRegion(face[0]) && !inRegion(face[1]) && !inRegion(face[2])) {
+      continue;
+    }
+    const double* a = unit(f->vertex(0));
+    const double* b = unit(f->vertex(1));
+    const double* c = unit(f->vertex(2));
+    if(f->is_ghost() || !smallCap(a, b, c, width)) {
+      return false;
+    }
+    for(int k = 0; k < 3; k++) {
+      const DToS::Face_handle g = f->neighbor(k);
+      if(cocircular(a, b, c, unit(g->vertex(g->index(f))))) {
+        fallback = true;
+        return false;
+      }
+    }
+    const int smallest = *std::min_element(face, face + 3);
+    if(inRegion(smallest)) {
+      faces.insert(faces.end(), face, face + 3);
+    }
+  }
+  return true;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Delaunay triangulation of the points, as the triplets of the one-based
+// indices of the vertices of its faces, with their ghost flags, sorted by
+// sortFaces; it is computed in parallel with `nthreads` threads when
+// possible, otherwise by serialDelaunay (`spatialsort`), which merges the
+// points found equal by CGAL; returns the dimension of the triangulation
+int parallelDelaunay(
+    const Traits& ball, const std::vector<PointOnSphere>& spoints,
+    std::vector<SPoint3>& projections, bool spatialsort, int nthreads,
+    std::vector<int>& mapping, std::vector<int>& faces,
+    std::vector<char>& ghosts
+) {
+  const int npoints = spoints.size();
+  const SPoint3 O = ball.center();
+  const double radius = ball.radius();
+  std::atomic<bool> fallback(nthreads < 2 || npoints < minParallelPoints);
+  if(!fallback) {
+    const std::vector<std::pair<uint64_t, int>> keys =
+      hilbertKeys(projections, O, radius, nthreads);
+    std::vector<int> ranks(npoints);
+    std::vector<double> units(3 * npoints);
+    std::vector<uint32_t> coordinates(3 * npoints);
+    parallelFor(npoints, nthreads, [&](int begin, int end, int) {
+      for(int i = begin; i < end; i++) {
+        const SPoint3& p = projections[i];
+        units[3*i]     = (p.x() - O.x()) / radius;
+        units[3*i + 1] = (p.y() - O.y()) / radius;
+        units[3*i + 2] = (p.z() - O.z()) / radius;
+        hilbertCoordinates(p, O, radius, &coordinates[3*i]);
+        // `i` is also a rank in the Hilbert order
+        ranks[keys[i].second] = i;
+      }
+    });
+    // the cells are about eight times as wide as the mean distance between
+    // two neighboring points
+    const double spacing = sqrt(4.0 * 3.141592653589793 / npoints);
+    const int level = std::max(
+      2, std::min(hilbertBits, int(floor(1.0 - log2(8.0 * spacing))))
+    );
+    const int nregions = std::max(4 * nthreads, npoints / 100000);
+    std::vector<std::vector<int>> regionFaces(nregions);
+    parallelFor(nregions, nthreads, [&](int begin, int end, int) {
+      for(int r = begin; r < end; r++) {
+        const int first = int(int64_t(npoints) * r / nregions);
+        const int last = int(int64_t(npoints) * (r + 1) / nregions);
+        // at level 1, the neighboring cells cover the whole sphere
+        int l = level;
+        while(!fallback && !triangulateRegion(
+            ball, spoints, keys, ranks, units, coordinates, first, last, l,
+            fallback, regionFaces[r]
+          )) {
+          if(--l < 2) {
+            fallback = true;
+          }
+        }
+      }
+    }, 1);
+    if(!fallback) {
+      // a triangulation of the sphere has 2n-4 faces
+      size_t nfaces = 0;
+      for(const std::vector<int>& rfaces : regionFaces) {
+        nfaces += rfaces.size() / 3;
+      }
+      fallback = nfaces != size_t(2 * npoints - 4);
+    }
+    if(!fallback) {
+      faces.clear();
+      faces.reserve(3 * (2 * npoints - 4));
+      for(std::vector<int>& rfaces : regionFaces) {
+        faces.insert(faces.end(), rfaces.begin(), rfaces.end());
+        std::vector<int>().swap(rfaces);
+      }
+      ghosts.assign(faces.size() / 3, false);
+    }
+  }
+  if(fallback) {
+    return serialDelaunay(
+      ball, spoints, projections, spatialsort, mapping, faces, ghosts
+    );
+  }
+  sortFaces(faces, ghosts, npoints);
+  return 2;
+}
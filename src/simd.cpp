@@ -0,0 +1,231 @@
+#include "simd.h"
+
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// The compilers may fuse a multiplication and an addition when the target has
+// FMA instructions (AVX-512, or any code compiled with -march=native), which
+// changes the rounding; this is disabled in all kernels.
+#if defined(__clang__)
+#define SIMD_NO_CONTRACT
+#define SIMD_BEGIN _Pragma("clang fp contract(off)")
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#elif defined(__GNUC__)
+#define SIMD_NO_CONTRACT __attribute__((optimize("fp-contract=off")))
+#define SIMD_BEGIN
+#define SIMD_TARGET(isa) \
+  __attribute__((target(isa), optimize("fp-contract=off")))
+#else
+#define SIMD_NO_CONTRACT
+#define SIMD_BEGIN
+#endif
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// scalar kernels, also used by the vectorized ones for the remaining points
+SIMD_NO_CONTRACT void midpointsScalar(
+    int count, int p, int q, int m, int stride, double* x, double* y,
+    double* z, double radius, const double* O
+) {
+  SIMD_BEGIN
+  for(int k = 0; k < count; k++, p += stride, q += stride, m += stride) {
+    const double mx = 0.5 * (x[p] + x[q]) - O[0];
+    const double my = 0.5 * (y[p] + y[q]) - O[1];
+    const double mz = 0.5 * (z[p] + z[q]) - O[2];
+    const double scale = radius / sqrt(mx*mx + my*my + mz*mz);
+    x[m] = O[0] + scale * mx;
+    y[m] = O[1] + scale * my;
+    z[m] = O[2] + scale * mz;
+  }
+}
+
+SIMD_NO_CONTRACT void normalsScalar(
+    size_t count, const double* xyz, const double* O, double* out
+) {
+  for(size_t i = 0; i < count; i++, xyz += 3, out += 6) {
+    out[0] = xyz[0];
+    out[1] = xyz[1];
+    out[2] = xyz[2];
+    out[3] = xyz[0] - O[0];
+    out[4] = xyz[1] - O[1];
+    out[5] = xyz[2] - O[2];
+  }
+}
+
+#ifdef SIMD_X86
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// gather of four doubles with all lanes enabled; the masked form is used
+// since its source operand is initialized, the plain one making GCC warn
+SIMD_TARGET("avx2") inline __m256d gatherAVX2(
+    const double* a, const __m128i indices
+) {
+  return _mm256_mask_i32gather_pd(
+    _mm256_setzero_pd(), a, indices,
+    _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8
+  );
+}
+
+// AVX2: four points at once, gathered from the strided arrays
+SIMD_TARGET("avx2") void midpointsAVX2(
+    int count, int p, int q, int m, int stride, double* x, double* y,
+    double* z, double radius, const double* O
+) {
+  SIMD_BEGIN
+  const __m128i lanes = _mm_mullo_epi32(
+    _mm_set_epi32(3, 2, 1, 0), _mm_set1_epi32(stride)
+  );
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d r = _mm256_set1_pd(radius);
+  const __m256d ox = _mm256_set1_pd(O[0]);
+  const __m256d oy = _mm256_set1_pd(O[1]);
+  const __m256d oz = _mm256_set1_pd(O[2]);
+  alignas(32) double bx[4], by[4], bz[4];
+  int k = 0;
+  for(; k + 4 <= count; k += 4) {
+    const __m128i ip = _mm_add_epi32(_mm_set1_epi32(p), lanes);
+    const __m128i iq = _mm_add_epi32(_mm_set1_epi32(q), lanes);
+    const __m256d mx = _mm256_sub_pd(_mm256_mul_pd(half, _mm256_add_pd(
+      gatherAVX2(x, ip), gatherAVX2(x, iq)
+    )), ox);
+    const __m256d my = _mm256_sub_pd(_mm256_mul_pd(half, _mm256_add_pd(
+      gatherAVX2(y, ip), gatherAVX2(y, iq)
+    )), oy);
+    const __m256d mz = _mm256_sub_pd(_mm256_mul_pd(half, _mm256_add_pd(
+      gatherAVX2(z, ip), gatherAVX2(z, iq)
+    )), oz);
+    const __m256d norm2 = _mm256_add_pd(_mm256_add_pd(
+      _mm256_mul_pd(mx, mx), _mm256_mul_pd(my, my)
+    ), _mm256_mul_pd(mz, mz));
+    const __m256d scale = _mm256_div_pd(r, _mm256_sqrt_pd(norm2));
+    _mm256_store_pd(bx, _mm256_add_pd(ox, _mm256_mul_pd(scale, mx)));
+    _mm256_store_pd(by, _mm256_add_pd(oy, _mm256_mul_pd(scale, my)));
+    _mm256_store_pd(bz, _mm256_add_pd(oz, _mm256_mul_pd(scale, mz)));
+    for(int l = 0; l < 4; l++, m += stride) {
+      x[m] = bx[l];
+      y[m] = by[l];
+      z[m] = bz[l];
+    }
+    p += 4 * stride;
+    q += 4 * stride;
+  }
+  midpointsScalar(count - k, p, q, m, stride, x, y, z, radius, O);
+}
+
+// a vertex is loaded with its three coordinates and the first one of the next
+// vertex, and stored twice, the fourth lane being overwritten by the next
+// store; the last vertex is left to the scalar kernel
+SIMD_TARGET("avx2") void normalsAVX2(
+    size_t count, const double* xyz, const double* O, double* out
+) {
+  const __m256d o = _mm256_set_pd(0, O[2], O[1], O[0]);
+  size_t i = 0;
+  for(; i + 1 < count; i++, xyz += 3, out += 6) {
+    const __m256d v = _mm256_loadu_pd(xyz);
+    _mm256_storeu_pd(out, v);
+    _mm256_storeu_pd(out + 3, _mm256_sub_pd(v, o));
+  }
+  normalsScalar(count - i, xyz, O, out);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// gather of eight doubles and square roots with all lanes enabled, in their
+// masked forms for the same reason
+SIMD_TARGET("avx512f") inline __m512d gatherAVX512(
+    const double* a, const __m256i indices
+) {
+  return _mm512_mask_i32gather_pd(
+    _mm512_setzero_pd(), __mmask8(0xFF), indices, a, 8
+  );
+}
+
+SIMD_TARGET("avx512f") inline __m512d sqrtAVX512(const __m512d v) {
+  return _mm512_mask_sqrt_pd(v, __mmask8(0xFF), v);
+}
+
+// AVX-512: eight points at once, gathered from and scattered to the strided
+// arrays
+SIMD_TARGET("avx512f") void midpointsAVX512(
+    int count, int p, int q, int m, int stride, double* x, double* y,
+    double* z, double radius, const double* O
+) {
+  SIMD_BEGIN
+  const __m256i lanes = _mm256_mullo_epi32(
+    _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0), _mm256_set1_epi32(stride)
+  );
+  const __m512d half = _mm512_set1_pd(0.5);
+  const __m512d r = _mm512_set1_pd(radius);
+  const __m512d ox = _mm512_set1_pd(O[0]);
+  const __m512d oy = _mm512_set1_pd(O[1]);
+  const __m512d oz = _mm512_set1_pd(O[2]);
+  int k = 0;
+  for(; k + 8 <= count; k += 8) {
+    const __m256i ip = _mm256_add_epi32(_mm256_set1_epi32(p), lanes);
+    const __m256i iq = _mm256_add_epi32(_mm256_set1_epi32(q), lanes);
+    const __m256i im = _mm256_add_epi32(_mm256_set1_epi32(m), lanes);
+    const __m512d mx = _mm512_sub_pd(_mm512_mul_pd(half, _mm512_add_pd(
+      gatherAVX512(x, ip), gatherAVX512(x, iq)
+    )), ox);
+    const __m512d my = _mm512_sub_pd(_mm512_mul_pd(half, _mm512_add_pd(
+      gatherAVX512(y, ip), gatherAVX512(y, iq)
+    )), oy);
+    const __m512d mz = _mm512_sub_pd(_mm512_mul_pd(half, _mm512_add_pd(
+      gatherAVX512(z, ip), gatherAVX512(z, iq)
+    )), oz);
+    const __m512d norm2 = _mm512_add_pd(_mm512_add_pd(
+      _mm512_mul_pd(mx, mx), _mm512_mul_pd(my, my)
+    ), _mm512_mul_pd(mz, mz));
+    const __m512d scale = _mm512_div_pd(r, sqrtAVX512(norm2));
+    const __m512d px = _mm512_add_pd(ox, _mm512_mul_pd(scale, mx));
+    const __m512d py = _mm512_add_pd(oy, _mm512_mul_pd(scale, my));
+    const __m512d pz = _mm512_add_pd(oz, _mm512_mul_pd(scale, mz));
+    _mm512_i32scatter_pd(x, im, px, 8);
+    _mm512_i32scatter_pd(y, im, py, 8);
+    _mm512_i32scatter_pd(z, im, pz, 8);
+    p += 8 * stride;
+    q += 8 * stride;
+    m += 8 * stride;
+  }
+  midpointsScalar(count - k, p, q, m, stride, x, y, z, radius, O);
+}
+
+#endif
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+const SimdKernels& simdScalarKernels() {
+  static const SimdKernels kernels = {
+    midpointsScalar, normalsScalar, "scalar"
+  };
+  return kernels;
+}
+
+SimdKernels selectKernels() {
+  SimdKernels kernels = simdScalarKernels();
+#ifdef SIMD_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) {
+    kernels.sphericalMidpoints = midpointsAVX2;
+    kernels.interleaveNormals = normalsAVX2;
+    kernels.name = "avx2";
+  }
+  if(__builtin_cpu_supports("avx512f")) {
+    kernels.sphericalMidpoints = midpointsAVX512;
+    kernels.name = "avx512";
+  }
+#endif
+  return kernels;
+}
+
+const SimdKernels& simdKernels() {
+  static const SimdKernels kernels = selectKernels();
+  return kernels;
+}
@@ -0,0 +1,40 @@
+#ifndef __SIMD_HEADER__
+#define __SIMD_HEADER__
+
+#include <cstddef>
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Streaming kernels of the subdivision, with a scalar version and, on x86-64
+// with GCC or Clang, some AVX2 and AVX-512 versions compiled for these
+// instruction sets only and chosen at run time according to the processor.
+// All versions perform the same operations in the same order without fused
+// multiply-adds, so they give bitwise identical results: two faces sharing
+// an edge compute the same points on it whatever the version. This holds as
+// well for the inlined subdivision of sphericalMesh.h used up to level 5,
+// which also disables the fused multiply-adds; kernels_benchmark checks it.
+
+// the points m + k*stride, k = 0, ..., count-1, of the arrays x, y, z are set
+// to the projections on the sphere (center O) of the midpoints of the points
+// p + k*stride and q + k*stride
+typedef void (*MidpointsKernel)(
+  int, int, int, int, int, double*, double*, double*, double, const double*
+);
+
+// writes `count` points given by (x, y, z) triplets in `out`, each one
+// followed by its normal, its position relative to the center O
+typedef void (*VerticesKernel)(size_t, const double*, const double*, double*);
+
+struct SimdKernels {
+  MidpointsKernel sphericalMidpoints;
+  VerticesKernel  interleaveNormals;
+  const char*     name;
+};
+
+// the kernels selected for the processor; `simdScalarKernels` are the
+// portable ones
+const SimdKernels& simdKernels();
+
+const SimdKernels& simdScalarKernels();
+
+#endif
@@ -7,40 +7,225 @@
 
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Triangulation_vertex_base_with_info_2.h>
+#include <CGAL/Triangulation_face_base_with_info_2.h>
 #include <CGAL/Delaunay_triangulation_on_sphere_2.h>
 #include <CGAL/Projection_on_sphere_traits_3.h>
 #include <CGAL/circulator.h>
 #include <CGAL/Circular_arc_point_3.h>
 
-#include <CGAL/Surface_mesh.h>
-#include <CGAL/squared_distance_3.h>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "parallel.h"
+#include "sphericalMesh.h"
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel       K;
 typedef CGAL::Projection_on_sphere_traits_3<K>                    Traits;
 typedef CGAL::Delaunay_triangulation_on_sphere_2<Traits>          DToS2;
 typedef Traits::Point_3                                           SPoint3;
+typedef Traits::Point_on_sphere_2                                 PointOnSphere;
 typedef Traits::Arc_on_sphere_2                                   Arc;
-typedef CGAL::Container_from_circulator<DToS2::Edge_circulator>   CC_Edges;
-typedef CGAL::Container_from_circulator<DToS2::Vertex_circulator> CC_Vertices;
 
 typedef CGAL::Triangulation_vertex_base_with_info_2<int, K>       Vbi2;
 typedef CGAL::Triangulation_on_sphere_vertex_base_2<Traits, Vbi2> Vb;
-typedef CGAL::Triangulation_on_sphere_face_base_2<Traits>         Fb;
+typedef CGAL::Triangulation_face_base_with_info_2<int, K>         Fbi2;
+typedef CGAL::Triangulation_on_sphere_face_base_2<Traits, Fbi2>   Fb;
 typedef CGAL::Triangulation_data_structure_2<Vb, Fb>              Tds;
 typedef CGAL::Delaunay_triangulation_on_sphere_2<Traits, Tds>     DToS;
+typedef CGAL::Container_from_circulator<DToS::Edge_circulator>    CC_Edges;
+typedef CGAL::Container_from_circulator<DToS::Vertex_circulator>  CC_Vertices;
 
 typedef K::Point_3                                       Point3;
-typedef CGAL::Surface_mesh<Point3>                       Mesh3;
-typedef Mesh3::Vertex_index                              VX3;
+
+// Voronoï cell: its site, its vertices and its mesh
+struct VoronoiCell {
+  double              site[3];
+  std::vector<double> vertices;
+  SMesh               mesh;
+};
+
+// Voronoï tessellation given by indices: the vertices of the k-th cell are the
+// Voronoï vertices cells[offsets[k]], ..., cells[offsets[k+1]-1] (zero-based
+// indices of the faces of the triangulation, of which they are the duals), in
+// counterclockwise order; neighbors[i] is the info of the site of the cell on
+// the other side of the arc joining the i-th vertex to the next one
+struct VoronoiTopology {
+  std::vector<int> offsets;
+  std::vector<int> cells;
+  std::vector<int> neighbors;
+};
+
+// Delaunay triangulation kept alive between calls from R. The info of a vertex
+// is the one-based identifier of its site, which is never reused; handles[i]
+// is the vertex of the site i+1, null if this site has been removed. The
+// sites whose Voronoï cells may have changed since the last report are
+// recorded in `modified` (flagged in `isModified`), the removed ones in
+// `removed`. The meshes computed on demand are cached, the ones of the
+// Voronoï cells by site and the ones of the Delaunay faces by the sorted
+// identifiers of their vertices, for the subdivision level `meshLevel` or
+// the tolerance `meshTolerance` if it is positive; a cached mesh is dropped
+// as soon as it may have changed, or as soon as its face is destroyed. The
+// keys of the cached face meshes are indexed by site in `siteFaces`.
+struct Tessellation {
+  DToS                                                      dtos;
+  std::vector<DToS::Vertex_handle>                          handles;
+  std::vector<char>                                         isModified;
+  std::vector<int>                                          modified;
+  std::vector<int>                                          removed;
+  std::unordered_map<int, SMesh>                            cellMeshes;
+  std::map<std::array<int, 3>, SMesh>                       faceMeshes;
+  std::unordered_map<int, std::vector<std::array<int, 3>>> siteFaces;
+  int                                                       meshLevel;
+  double                                                    meshTolerance;
+  Tessellation(const Traits& ball)
+    : dtos(ball), meshLevel(-1), meshTolerance(0) {}
+};
 
 
+// Optional instrumentation of an exported function: the wall time of each
+// stage of the computation and some counters; nothing is measured when
+// `enabled` is false. A stage ends when `stage` is called with its name.
+// `objects` counts the R vectors and lists it is given and the elements of
+// the lists, `seen` ensuring that an object is counted only once.
+struct Profile {
+  bool                                  enabled;
+  std::chrono::steady_clock::time_point last;
+  std::vector<std::string>              stages;
+  std::vector<double>                   seconds;
+  std::vector<std::string>              counters;
+  std::vector<double>                   counts;
+  std::unordered_set<SEXP>              seen;
+  explicit Profile(bool);
+  void stage(const std::string&);
+  void count(const std::string&, double);
+  void objects(SEXP);
+  Rcpp::List toList() const;
+};
+
 // -------------------------------------------------------------------------- //
 // -------------------------------------------------------------------------- //
 void Message(const std::string&);
 
+Rcpp::List renderMesh(
+  const Rcpp::NumericMatrix, const Rcpp::IntegerMatrix,
+  const Rcpp::IntegerVector
+);
+
+Rcpp::List SMeshToList(const SMesh&, const double*);
+
+Rcpp::RawVector encodeIndices(const int*, size_t, int, int);
+
+Rcpp::List compactMesh(
+  const Rcpp::RawVector, const Rcpp::RawVector, const Rcpp::IntegerVector
+);
+
+Rcpp::List SMeshToCompactList(const SMesh&, int);
+
+Rcpp::IntegerVector rowMapping(const std::vector<int>&);
+
+void polygonMetrics(
+  const double*, int, const double*, double&, double&, double[3]
+);
+
+Rcpp::List voronoiMetrics(
+  const std::vector<double>&, const VoronoiTopology&,
+  const std::vector<double>&, const double*, double, int
+);
+
+Rcpp::List delaunayMetrics(
+  const std::vector<SPoint3>&, const std::vector<int>&,
+  const std::vector<char>&, const double*, double, int
+);
+
+uint64_t hilbertKey(uint32_t[3]);
+
+void hilbertCoordinates(const SPoint3&, const SPoint3&, double, uint32_t[3]);
+
+std::vector<std::pair<uint64_t, int>> hilbertKeys(
+  const std::vector<SPoint3>&, const SPoint3&, double, int
+);
+
+std::vector<int> hilbertOrder(
+  const std::vector<SPoint3>&, const SPoint3&, double
+);
+
+void projectPoints(
+  const Traits&, const Rcpp::NumericMatrix, std::vector<PointOnSphere>&,
+  std::vector<SPoint3>&
+);
+
+// storage of the hash table of mergePoints, reused from one call to the next
+struct MergeScratch {
+  std::unordered_map<uint64_t, int> heads;
+  std::vector<int>                  next;
+};
+
+void mergePoints(
+  std::vector<PointOnSphere>&, std::vector<SPoint3>&, const SPoint3&, double,
+  double, MergeScratch&, std::vector<int>&
+);
+
+std::vector<int> mergePoints(
+  std::vector<PointOnSphere>&, std::vector<SPoint3>&, const SPoint3&, double,
+  double
+);
+
+std::vector<DToS::Vertex_handle> insertPoints(
+  DToS&, const std::vector<PointOnSphere>&, const std::vector<SPoint3>&, bool,
+  int
+);
+
+void mergeVertices(
+  const DToS&, const std::vector<DToS::Vertex_handle>&,
+  const std::vector<PointOnSphere>&, std::vector<SPoint3>&, std::vector<int>&
+);
+
+void triangulationFaces(const DToS&, std::vector<int>&, std::vector<char>&);
+
+void sortFaces(std::vector<int>&, std::vector<char>&, int);
+
+int serialDelaunay(
+  const Traits&, const std::vector<PointOnSphere>&, std::vector<SPoint3>&,
+  bool, std::vector<int>&, std::vector<int>&, std::vector<char>&
+);
+
+int parallelDelaunay(
+  const Traits&, const std::vector<PointOnSphere>&, std::vector<SPoint3>&,
+  bool, int, std::vector<int>&, std::vector<int>&, std::vector<char>&
+);
+
+std::vector<DToS::Face_handle> indexFaces(DToS&);
+
+std::vector<DToS::Vertex_handle> sortedVertices(const DToS&);
+
+std::vector<double> voronoiVertices(
+  const DToS&, const std::vector<DToS::Face_handle>&, int
+);
+
+std::vector<size_t> voronoiOffsets(
+  const DToS&, const std::vector<DToS::Vertex_handle>&, int
+);
+
+void voronoiCorners(
+  const DToS&, const std::vector<DToS::Vertex_handle>&,
+  const std::vector<size_t>&, int, int, int, int*, int*
+);
+
+void voronoiCell(
+  const DToS&, const DToS::Vertex_handle, const int*, int,
+  const std::vector<double>&, int, const int*, const int*, const double*,
+  const int*, FaceScratch&, VoronoiCell&
+);
+
 Rcpp::List sTriangle(
     Rcpp::NumericVector, Rcpp::NumericVector, Rcpp::NumericVector,
-    double, Rcpp::NumericVector, int
+    double, Rcpp::NumericVector, int, bool, double
 );
 
 #endif
@@ -0,0 +1,7 @@
+#ifndef __TYPES_HEADER__
+#define __TYPES_HEADER__
+
+// types used in the signatures of the exported functions
+#include "sphereTessellation.h"
+
+#endif
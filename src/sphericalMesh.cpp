@@ -0,0 +1,1112 @@
+#include "sphericalMesh.h"
+#include "parallel.h"
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// grid of the spherical triangle ABC after `level` quadrisections; the
+// common levels are specialized at compile time, the finer ones stream the
+// midpoints of each row through the vectorized kernel
+void subdivideTriangle(
+    int level, const double* A, const double* B, const double* C,
+    double radius, const double* O, double* x, double* y, double* z
+) {
+  switch(level) {
+    case 0:
+      subdivideGrid(Subdivisions<0>(), A, B, C, radius, O, x, y, z);
+      break;
+    case 1:
+      subdivideGrid(Subdivisions<1>(), A, B, C, radius, O, x, y, z);
+      break;
+    case 2:
+      subdivideGrid(Subdivisions<2>(), A, B, C, radius, O, x, y, z);
+      break;
+    case 3:
+      subdivideGrid(Subdivisions<3>(), A, B, C, radius, O, x, y, z);
+      break;
+    case 4:
+      subdivideGrid(Subdivisions<4>(), A, B, C, radius, O, x, y, z);
+      break;
+    case 5:
+      subdivideGrid(Subdivisions<5>(), A, B, C, radius, O, x, y, z);
+      break;
+    default:
+      streamGrid(
+        1 << level, A, B, C, radius, O, x, y, z,
+        simdKernels().sphericalMidpoints
+      );
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// same as subdivideGrid, the points of a row introduced at a given level
+// being computed by one call to `kernel`: they are 2s apart in the grid, and
+// so are their parents
+void streamGrid(
+    int n, const double* A, const double* B, const double* C,
+    double radius, const double* O, double* x, double* y, double* z,
+    MidpointsKernel kernel
+) {
+  const int a = gridIndex(n, 0, 0), b = gridIndex(n, n, 0),
+            c = gridIndex(n, 0, n);
+  x[a] = A[0]; y[a] = A[1]; z[a] = A[2];
+  x[b] = B[0]; y[b] = B[1]; z[b] = B[2];
+  x[c] = C[0]; y[c] = C[1]; z[c] = C[2];
+  for(int s = n / 2; s >= 1; s /= 2) {
+    const int step = 2 * s;
+    // points with an odd i and an even j, i = s, 3s, ... < n-j
+    for(int j = 0; j < n; j += step) {
+      const int count = (n - j + s - 1) / step;
+      kernel(
+        count, gridIndex(n, 0, j), gridIndex(n, step, j), gridIndex(n, s, j),
+        step, x, y, z, radius, O
+      );
+    }
+    for(int j = s; j < n; j += step) {
+      // even i, i = 0, 2s, ... < n-j
+      kernel(
+        (n - j + step - 1) / step, gridIndex(n, 0, j - s),
+        gridIndex(n, 0, j + s), gridIndex(n, 0, j), step, x, y, z, radius, O
+      );
+      // odd i, i = s, 3s, ... <= n-j
+      kernel(
+        (n - j + s) / step, gridIndex(n, step, j - s),
+        gridIndex(n, 0, j + s), gridIndex(n, s, j), step, x, y, z, radius, O
+      );
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// triangles of the grid of a triangle after `level` quadrisections
+void triangleFaces(int level, int* triangles, int base) {
+  switch(level) {
+    case 0:
+      gridTriangles(Subdivisions<0>(), triangles, base);
+      break;
+    case 1:
+      gridTriangles(Subdivisions<1>(), triangles, base);
+      break;
+    case 2:
+      gridTriangles(Subdivisions<2>(), triangles, base);
+      break;
+    case 3:
+      gridTriangles(Subdivisions<3>(), triangles, base);
+      break;
+    case 4:
+      gridTriangles(Subdivisions<4>(), triangles, base);
+      break;
+    case 5:
+      gridTriangles(Subdivisions<5>(), triangles, base);
+      break;
+    default:
+      gridTriangles(1 << level, triangles, base);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// numbers the edges of a triangulation; the first face meeting an edge owns it
+void edgeTopology(const std::vector<int>& faces, MeshTopology& topology) {
+  const int nfaces = faces.size() / 3;
+  topology.faceEdges.resize(3 * nfaces);
+  topology.owner.resize(3 * nfaces);
+  topology.nedges = 0;
+  std::unordered_map<uint64_t, int> edgeIds;
+  edgeIds.reserve(3 * nfaces / 2 + 1);
+  for(int f = 0; f < nfaces; f++) {
+    for(int s = 0; s < 3; s++) {
+      const int a = faces[3*f + s];
+      const int b = faces[3*f + (s + 1) % 3];
+      const uint64_t key = a < b
+        ? (uint64_t(a) << 32) | uint64_t(b)
+        : (uint64_t(b) << 32) | uint64_t(a);
+      const auto ins = edgeIds.emplace(key, topology.nedges);
+      topology.faceEdges[3*f + s] = ins.first->second;
+      topology.owner[3*f + s] = ins.second;
+      if(ins.second) {
+        topology.nedges++;
+      }
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// sizes the buffers of a mesh subdividing `level` times a triangulation; the
+// vertices of the triangulation come first, followed by the points on its
+// edges (n-1 per edge, ordered from the vertex with the lowest index) and
+// then the points inside its faces, so that each point is stored only once;
+// meshSize gives the numbers of points and triangles of this mesh
+void meshSize(
+    int nvertices, int nedges, int nfaces, int level, size_t& npoints,
+    size_t& ntriangles
+) {
+  const size_t n = size_t(1) << level;
+  npoints = nvertices + nedges * (n - 1) + nfaces * ((n - 1) * (n - 2) / 2);
+  ntriangles = nfaces * n * n;
+}
+
+void allocateMesh(
+    int nvertices, int nedges, int nfaces, int level, SMesh& smesh
+) {
+  size_t npoints, ntriangles;
+  meshSize(nvertices, nedges, nfaces, level, npoints, ntriangles);
+  smesh.vertices.resize(3 * npoints);
+  smesh.faces.resize(3 * ntriangles);
+  smesh.offsets.resize(nfaces + 1);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// destinations of the subdivided faces: a SMesh, or the render-ready buffers
+// of a PackedMesh; `point` stores the g-th point, `triangles` gives where the
+// vertex indices of the t-th triangle go, shifted by `shift`, and `face`
+// records that the triangles of the f-th face are the `count` ones from the
+// t-th one
+struct SMeshSink {
+  static constexpr int shift = 0;
+  SMesh& smesh;
+  void point(size_t g, double x, double y, double z) const {
+    double* v = &smesh.vertices[3 * g];
+    v[0] = x; v[1] = y; v[2] = z;
+  }
+  int* triangles(size_t t) const {
+    return &smesh.faces[3 * t];
+  }
+  void face(int f, size_t t, size_t) const {
+    smesh.offsets[f] = int(t);
+  }
+};
+
+struct PackedSink {
+  static constexpr int shift = 1;
+  const PackedMesh& packed;
+  const double*     O;
+  void point(size_t g, double x, double y, double z) const {
+    if(packed.vertices) {
+      double* v = packed.vertices + 6 * g;
+      v[0] = x; v[1] = y; v[2] = z;
+      v[3] = x - O[0]; v[4] = y - O[1]; v[5] = z - O[2];
+    } else {
+      float* v = packed.positions + 3 * g;
+      v[0] = float(x); v[1] = float(y); v[2] = float(z);
+    }
+  }
+  int* triangles(size_t t) const {
+    return packed.indices + 3 * t;
+  }
+  void face(int f, size_t t, size_t count) const {
+    if(packed.offsets) {
+      packed.offsets[f] = int(t);
+    }
+    if(packed.ids) {
+      std::fill(packed.ids + t, packed.ids + t + count, f + 1);
+    }
+  }
+};
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// indices in the mesh allocated by allocateMesh of the points of the grid of
+// the f-th face of a triangulation subdivided n times along each side
+void faceGrid(
+    int f, int n, int nvertices, const int* faces,
+    const MeshTopology& topology, int* global
+) {
+  const int nedgePoints = n - 1;
+  const int ninteriorPoints = (n - 1) * (n - 2) / 2;
+  const int firstEdgePoint = nvertices;
+  const int firstInteriorPoint = nvertices + topology.nedges * nedgePoints;
+  const int a = faces[3*f];
+  const int b = faces[3*f + 1];
+  const int c = faces[3*f + 2];
+  // corners
+  global[gridIndex(n, 0, 0)] = a;
+  global[gridIndex(n, n, 0)] = b;
+  global[gridIndex(n, 0, n)] = c;
+  // sides AB, BC, CA
+  const int* faceEdges = &topology.faceEdges[3*f];
+  const int eAB = firstEdgePoint + faceEdges[0] * nedgePoints - 1;
+  const int eBC = firstEdgePoint + faceEdges[1] * nedgePoints - 1;
+  const int eCA = firstEdgePoint + faceEdges[2] * nedgePoints - 1;
+  for(int t = 1; t < n; t++) {
+    global[gridIndex(n, t, 0)]     = eAB + (a < b ? t : n - t);
+    global[gridIndex(n, n - t, t)] = eBC + (b < c ? t : n - t);
+    global[gridIndex(n, 0, n - t)] = eCA + (c < a ? t : n - t);
+  }
+  // interior
+  int k = firstInteriorPoint + f * ninteriorPoints;
+  for(int j = 1; j < n - 1; j++) {
+    for(int i = 1; i + j < n; i++) {
+      global[gridIndex(n, i, j)] = k++;
+    }
+  }
+}
+
+// subdivides the f-th face of a triangulation into the mesh allocated by
+// allocateMesh, after copying the vertices of the triangulation in it; only
+// the points of the edges owned by the face are written, so that distinct
+// faces can be processed concurrently; `local` holds the triangles of the
+// grid
+template <typename Sink>
+void subdivideFaceTo(
+    int f, const double* vertices, int nvertices, const int* faces,
+    const MeshTopology& topology, int level, double radius, const double* O,
+    const int* local, FaceScratch& scratch, const Sink& sink
+) {
+  const int n = 1 << level;
+  const int npointsGrid = gridSize(n);
+  const int ntriangles = n * n;
+  scratch.grid.resize(3 * npointsGrid);
+  scratch.global.resize(npointsGrid);
+  double* x = scratch.grid.data();
+  double* y = x + npointsGrid;
+  double* z = y + npointsGrid;
+  int* global = scratch.global.data();
+  subdivideTriangle(
+    level, &vertices[3 * faces[3*f]], &vertices[3 * faces[3*f + 1]],
+    &vertices[3 * faces[3*f + 2]], radius, O, x, y, z
+  );
+  faceGrid(f, n, nvertices, faces, topology, global);
+  // store the points of the owned sides and the interior points
+  const char* owner = &topology.owner[3*f];
+  for(int j = 0; j <= n; j++) {
+    for(int i = 0; i + j <= n; i++) {
+      const bool onAB = j == 0, onBC = i + j == n, onCA = i == 0;
+      const int nsides = onAB + onBC + onCA;
+      if(nsides == 2) {
+        continue; // corner
+      }
+      if(nsides == 1 && !owner[onAB ? 0 : (onBC ? 1 : 2)]) {
+        continue;
+      }
+      const int l = gridIndex(n, i, j);
+      sink.point(global[l], x[l], y[l], z[l]);
+    }
+  }
+  // triangles
+  const size_t first = size_t(f) * ntriangles;
+  sink.face(f, first, ntriangles);
+  int* triangles = sink.triangles(first);
+  for(int k = 0; k < 3 * ntriangles; k++) {
+    triangles[k] = global[local[k]] + Sink::shift;
+  }
+}
+
+void subdivideFace(
+    int f, const double* vertices, int nvertices, const int* faces,
+    const MeshTopology& topology, int level, double radius, const double* O,
+    const int* local, FaceScratch& scratch, SMesh& smesh
+) {
+  subdivideFaceTo(
+    f, vertices, nvertices, faces, topology, level, radius, O, local,
+    scratch, SMeshSink{smesh}
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// subdivides `level` times each face of a spherical triangulation, each point
+// being computed and stored only once; the faces are subdivided with
+// `nthreads` threads
+SMesh subdivideMesh(
+    const std::vector<double>& vertices, const std::vector<int>& faces,
+    int level, double radius, const double* O, int nthreads
+) {
+  const int n = 1 << level;
+  const int nvertices = vertices.size() / 3;
+  const int nfaces = faces.size() / 3;
+  MeshTopology topology;
+  edgeTopology(faces, topology);
+  SMesh smesh;
+  allocateMesh(nvertices, topology.nedges, nfaces, level, smesh);
+  std::copy(vertices.begin(), vertices.end(), smesh.vertices.begin());
+  // the local triangles of a grid are the same for all faces
+  std::vector<int> local(3 * n * n);
+  triangleFaces(level, local.data(), 0);
+  // the faces write to disjoint locations
+  parallelFor(nfaces, nthreads, [&](int begin, int end, int) {
+    FaceScratch scratch;
+    for(int f = begin; f < end; f++) {
+      subdivideFace(
+        f, vertices.data(), nvertices, faces.data(), topology, level, radius,
+        O, local.data(), scratch, smesh
+      );
+    }
+  });
+  smesh.offsets[nfaces] = nfaces * n * n;
+  return smesh;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// number of quadrisections after which the point t of a side divided into
+// 2^level arcs appears, 0 < t < 2^level
+inline int pointLevel(int level, int t) {
+  while(!(t & 1)) {
+    t >>= 1;
+    level--;
+  }
+  return level;
+}
+
+// Turns a mesh built by subdivideMesh (`level` quadrisections of the faces of
+// a triangulation with `nvertices` vertices and the given topology) into a
+// pyramid of levels of detail. The vertices of the mesh are sorted by the
+// level at which they appear, so that the ones of the l-th level are the
+// first pyramid.nvertices[l], and the triangles of the coarser levels are
+// stored in pyramid.faces, face after face as in the mesh; the triangles of
+// the finest level are the ones of the mesh, renumbered. Since the points of
+// a level are midpoints of the points of the previous one, they are shared
+// by all finer levels and no point is computed again.
+void meshPyramid(
+    int nvertices, const std::vector<int>& faces,
+    const MeshTopology& topology, int level, int nthreads, SMesh& smesh,
+    MeshPyramid& pyramid
+) {
+  const int n = 1 << level;
+  const int nfaces = faces.size() / 3;
+  const size_t npoints = smesh.vertices.size() / 3;
+  // level of each point: the vertices of the triangulation, then the points
+  // of the edges, then the points inside the faces, as laid out by
+  // allocateMesh
+  std::vector<int> born(npoints, 0);
+  size_t k = nvertices;
+  for(int e = 0; e < topology.nedges; e++) {
+    for(int t = 1; t < n; t++) {
+      born[k++] = pointLevel(level, t);
+    }
+  }
+  for(int f = 0; f < nfaces; f++) {
+    for(int j = 1; j < n - 1; j++) {
+      for(int i = 1; i + j < n; i++) {
+        born[k++] = std::max(pointLevel(level, i), pointLevel(level, j));
+      }
+    }
+  }
+  // stable counting sort of the points by level
+  std::vector<size_t> first(level + 2, 0);
+  for(const int l : born) {
+    first[l + 1]++;
+  }
+  for(int l = 0; l <= level; l++) {
+    first[l + 1] += first[l];
+  }
+  pyramid.nvertices.assign(first.begin() + 1, first.end());
+  std::vector<int> renumber(npoints);
+  std::vector<double> vertices(3 * npoints);
+  for(size_t p = 0; p < npoints; p++) {
+    const size_t q = first[born[p]]++;
+    renumber[p] = int(q);
+    std::copy(&smesh.vertices[3*p], &smesh.vertices[3*p] + 3, &vertices[3*q]);
+  }
+  smesh.vertices.swap(vertices);
+  for(int& index : smesh.faces) {
+    index = renumber[index];
+  }
+  // coarser levels: the point (i, j) of the grid of the l-th level is the
+  // point (i*s, j*s) of the finest grid, s = 2^(level-l)
+  pyramid.faces.resize(level);
+  std::vector<std::vector<int>> locals(level);
+  std::vector<int> fine;
+  for(int l = 0; l < level; l++) {
+    const int m = 1 << l, s = n / m;
+    fine.resize(gridSize(m));
+    for(int j = 0; j <= m; j++) {
+      for(int i = 0; i + j <= m; i++) {
+        fine[gridIndex(m, i, j)] = gridIndex(n, i * s, j * s);
+      }
+    }
+    locals[l].resize(3 * m * m);
+    triangleFaces(l, locals[l].data(), 0);
+    for(int& g : locals[l]) {
+      g = fine[g];
+    }
+    pyramid.faces[l].resize(3 * size_t(nfaces) * m * m);
+  }
+  parallelFor(nfaces, nthreads, [&](int begin, int end, int) {
+    std::vector<int> global(gridSize(n));
+    for(int f = begin; f < end; f++) {
+      faceGrid(f, n, nvertices, faces.data(), topology, global.data());
+      for(int l = 0; l < level; l++) {
+        const int m = 1 << l;
+        int* triangles = &pyramid.faces[l][3 * size_t(f) * m * m];
+        for(const int g : locals[l]) {
+          *triangles++ = renumber[global[g]];
+        }
+      }
+    }
+  });
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// faces (s, i, i+1) of the star of a polygon from a point s inside it, the
+// ncorners-th point, and their edges: edge i is the side (i, i+1) of the
+// polygon (indices modulo ncorners) and edge ncorners+i is the spoke (s, i);
+// the i-th face owns its side and its first spoke
+void starTopology(
+    int ncorners, std::vector<int>& faces, MeshTopology& topology
+) {
+  const int nfaces = ncorners;
+  faces.resize(3 * nfaces);
+  topology.faceEdges.resize(3 * nfaces);
+  topology.owner.resize(3 * nfaces);
+  topology.nedges = 2 * ncorners;
+  for(int i = 0; i < nfaces; i++) {
+    const int next = i == ncorners - 1 ? 0 : i + 1;
+    faces[3*i]     = ncorners;
+    faces[3*i + 1] = i;
+    faces[3*i + 2] = next;
+    topology.faceEdges[3*i]     = ncorners + i;
+    topology.faceEdges[3*i + 1] = i;
+    topology.faceEdges[3*i + 2] = ncorners + next;
+    topology.owner[3*i]     = true;
+    topology.owner[3*i + 1] = true;
+    topology.owner[3*i + 2] = false;
+  }
+}
+
+// subdivides `level` times the star triangulation (s, i, i+1) of a spherical
+// polygon; `points` are the `ncorners` vertices of the polygon followed by
+// the point s, which must lie inside the polygon, such as the site of a
+// Voronoï cell; the spokes and the center of the star are shared by the
+// triangles; the topology of the star is known in closed form and the mesh
+// is sized before being filled; `local` holds the triangles of the grid
+void subdivideStar(
+    const double* points, int ncorners, int level, double radius,
+    const double* O, const int* local, FaceScratch& scratch, SMesh& smesh
+) {
+  const int n = 1 << level;
+  const int nfaces = ncorners;
+  std::vector<int>& faces = scratch.faces;
+  MeshTopology& topology = scratch.topology;
+  starTopology(ncorners, faces, topology);
+  allocateMesh(ncorners + 1, topology.nedges, nfaces, level, smesh);
+  std::copy(points, points + 3 * (ncorners + 1), smesh.vertices.begin());
+  for(int f = 0; f < nfaces; f++) {
+    subdivideFace(
+      f, points, ncorners + 1, faces.data(), topology, level, radius, O,
+      local, scratch, smesh
+    );
+  }
+  smesh.offsets[nfaces] = nfaces * n * n;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// writes a mesh in render-ready buffers, from the vertex `vbase` and the
+// triangle `tbase`: six numbers per vertex in `vbuffer`, its coordinates and
+// its normal (its position relative to the center O), and three one-based
+// vertex indices per triangle in `ibuffer`; distinct meshes can be written
+// concurrently at distinct locations; there is no color channel, the colors
+// depending on the plotting arguments, and rgl copies these buffers into its
+// own homogeneous ones in any case
+void packMesh(
+    const SMesh& smesh, const double* O, size_t vbase, size_t tbase,
+    double* vbuffer, int* ibuffer
+) {
+  simdKernels().interleaveNormals(
+    smesh.vertices.size() / 3, smesh.vertices.data(), O, vbuffer + 6 * vbase
+  );
+  packTriangles(smesh, vbase, tbase, ibuffer);
+}
+
+// same as packMesh for the compact form: three single-precision numbers per
+// vertex in `pbuffer`, its coordinates, without normal
+void packMeshCompact(
+    const SMesh& smesh, size_t vbase, size_t tbase, float* pbuffer,
+    int* ibuffer
+) {
+  std::copy(
+    smesh.vertices.begin(), smesh.vertices.end(), pbuffer + 3 * vbase
+  );
+  packTriangles(smesh, vbase, tbase, ibuffer);
+}
+
+// one-based vertex indices of the triangles of a mesh, as in packMesh
+void packTriangles(
+    const SMesh& smesh, size_t vbase, size_t tbase, int* ibuffer
+) {
+  const int shift = int(vbase) + 1;
+  int* t = ibuffer + 3 * tbase;
+  for(const int index : smesh.faces) {
+    *t++ = index + shift;
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// smallest level such that the chords of the arc PQ divided into 2^level
+// arcs are within `tolerance` of the sphere; a chord of angle t is at the
+// distance radius * (1 - cos(t/2)) = 2 * radius * sin(t/4)^2 of its arc
+int edgeLevel(
+    const double* P, const double* Q, double radius, const double* O,
+    double tolerance
+) {
+  const double u[3] = {P[0] - O[0], P[1] - O[1], P[2] - O[2]};
+  const double v[3] = {Q[0] - O[0], Q[1] - O[1], Q[2] - O[2]};
+  const double cx = u[1]*v[2] - u[2]*v[1];
+  const double cy = u[2]*v[0] - u[0]*v[2];
+  const double cz = u[0]*v[1] - u[1]*v[0];
+  const double angle = atan2(
+    sqrt(cx*cx + cy*cy + cz*cz), u[0]*v[0] + u[1]*v[1] + u[2]*v[2]
+  );
+  int level = 0;
+  double s = sin(angle / 4);
+  while(level < maxAdaptiveLevel && 2 * radius * s * s > tolerance) {
+    level++;
+    s = sin(angle / (4 << level));
+  }
+  return level;
+}
+
+// distance from O to the closest point of the flat triangle (p, q, r) of the
+// grid (Ericson, Real-Time Collision Detection, section 5.1.5)
+double triangleDistance(
+    const double* x, const double* y, const double* z, int p, int q, int r,
+    const double* O
+) {
+  const double a[3] = {x[p], y[p], z[p]};
+  const double ab[3] = {x[q] - a[0], y[q] - a[1], z[q] - a[2]};
+  const double ac[3] = {x[r] - a[0], y[r] - a[1], z[r] - a[2]};
+  const double ao[3] = {O[0] - a[0], O[1] - a[1], O[2] - a[2]};
+  auto dot = [](const double* u, const double* v) {
+    return u[0]*v[0] + u[1]*v[1] + u[2]*v[2];
+  };
+  const double d1 = dot(ab, ao), d2 = dot(ac, ao);
+  double v = 0, w = 0;
+  if(d1 > 0 || d2 > 0) {
+    const double bo[3] = {ao[0] - ab[0], ao[1] - ab[1], ao[2] - ab[2]};
+    const double co[3] = {ao[0] - ac[0], ao[1] - ac[1], ao[2] - ac[2]};
+    const double d3 = dot(ab, bo), d4 = dot(ac, bo);
+    const double d5 = dot(ab, co), d6 = dot(ac, co);
+    const double va = d3*d6 - d5*d4, vb = d5*d2 - d1*d6, vc = d1*d4 - d3*d2;
+    if(d3 >= 0 && d4 <= d3) {
+      v = 1;
+    } else if(d6 >= 0 && d5 <= d6) {
+      w = 1;
+    } else if(vc <= 0 && d1 >= 0 && d3 <= 0) {
+      v = d1 / (d1 - d3);
+    } else if(vb <= 0 && d2 >= 0 && d6 <= 0) {
+      w = d2 / (d2 - d6);
+    } else if(va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+      w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+      v = 1 - w;
+    } else {
+      const double denom = 1 / (va + vb + vc);
+      v = vb * denom;
+      w = vc * denom;
+    }
+  }
+  const double dx = ao[0] - v*ab[0] - w*ac[0];
+  const double dy = ao[1] - v*ab[1] - w*ac[1];
+  const double dz = ao[2] - v*ab[2] - w*ac[2];
+  return sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+// index of the t-th grid point of the s-th side (AB, BC, CA) of a grid with n
+// subdivisions, from the first vertex of this side
+inline int sidePoint(int n, int s, int t) {
+  return s == 0 ? gridIndex(n, t, 0)
+    : (s == 1 ? gridIndex(n, n - t, t) : gridIndex(n, 0, n - t));
+}
+
+// merges the points of the sides of a grid with n subdivisions with the
+// points of edges having `arcs[s]` arcs (a divisor of n): the t-th point of
+// the s-th side is merged with the grid point of the round(t/m)-th point of
+// its edge, m = n/arcs[s]; `merged` receives the grid index of the point
+// merged with each grid point
+void mergeGrid(int n, const int* arcs, int* merged) {
+  const int npointsGrid = gridSize(n);
+  for(int l = 0; l < npointsGrid; l++) {
+    merged[l] = l;
+  }
+  for(int s = 0; s < 3; s++) {
+    const int m = n / arcs[s];
+    for(int t = 1; t < n; t++) {
+      merged[sidePoint(n, s, t)] = sidePoint(n, s, (t + m / 2) / m * m);
+    }
+  }
+}
+
+// smallest level, from `level`, such that the triangles of the grid of the
+// spherical triangle ABC are within `tolerance` of the sphere; the deviation
+// of a flat triangle whose vertices lie on the sphere is the radius minus
+// the distance from the center to the triangle. If `sideLevels` is not
+// null, the points of the sides are merged with the points of edges having
+// these levels, and the flat triangles are ignored. The grid and the local
+// triangles are computed in `scratch`.
+int faceLevel(
+    int level, const double* A, const double* B, const double* C,
+    const int* sideLevels, double radius, const double* O, double tolerance,
+    FaceScratch& scratch
+) {
+  for(; level < maxAdaptiveLevel; level++) {
+    const int n = 1 << level;
+    const int npointsGrid = gridSize(n);
+    scratch.grid.resize(3 * npointsGrid);
+    scratch.local.resize(3 * n * n);
+    scratch.merged.resize(npointsGrid);
+    double* x = scratch.grid.data();
+    double* y = x + npointsGrid;
+    double* z = y + npointsGrid;
+    int* merged = scratch.merged.data();
+    subdivideTriangle(level, A, B, C, radius, O, x, y, z);
+    gridTriangles(n, scratch.local.data(), 0);
+    if(sideLevels) {
+      const int arcs[3] = {
+        1 << sideLevels[0], 1 << sideLevels[1], 1 << sideLevels[2]
+      };
+      mergeGrid(n, arcs, merged);
+    } else {
+      for(int l = 0; l < npointsGrid; l++) {
+        merged[l] = l;
+      }
+    }
+    const int* t = scratch.local.data();
+    bool ok = true;
+    for(int k = 0; k < n * n && ok; k++, t += 3) {
+      const int p = merged[t[0]], q = merged[t[1]], r = merged[t[2]];
+      ok = p == q || q == r || r == p ||
+        radius - triangleDistance(x, y, z, p, q, r, O) <= tolerance;
+    }
+    if(ok) {
+      break;
+    }
+  }
+  return level;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// levels of the adaptive subdivision of a triangulation within `tolerance` of
+// the sphere and places of the points and triangles in the mesh. Each face
+// first gets the level it needs; an edge shared by two faces gets the larger
+// level of these faces, and the level of a border edge of the triangulation
+// only depends on its two vertices, so that two triangulations sharing a
+// border edge divide it at the same points. Then the level of a face is
+// raised to the levels of its edges, and further until its triangles merged
+// along its coarser edges (see subdivideFaceAdaptive) are within the
+// tolerance; the border edges are given a margin so that this converges.
+// The vertices of the triangulation come first in the mesh, followed by the
+// points inside the edges and then the points inside the faces. `scratch`
+// is used when there is a single thread; only its grid is touched.
+void adaptiveLayout(
+    const double* vertices, int nvertices, const std::vector<int>& faces,
+    const MeshTopology& topology, double radius, const double* O,
+    double tolerance, int nthreads, FaceScratch& scratch,
+    AdaptiveLayout& layout
+) {
+  const int nfaces = faces.size() / 3;
+  const int nedges = topology.nedges;
+  std::vector<int>& edgeLevels = layout.edgeLevels;
+  std::vector<int>& faceLevels = layout.faceLevels;
+  edgeLevels.assign(nedges, 0);
+  faceLevels.resize(nfaces);
+  // the border edges are the ones met by a single face, which owns them
+  std::vector<char> border(nedges, 1);
+  for(int f = 0; f < nfaces; f++) {
+    for(int s = 0; s < 3; s++) {
+      if(!topology.owner[3*f + s]) {
+        border[topology.faceEdges[3*f + s]] = 0;
+      }
+    }
+  }
+  for(int f = 0; f < nfaces; f++) {
+    for(int s = 0; s < 3; s++) {
+      const int e = topology.faceEdges[3*f + s];
+      if(border[e]) {
+        const int a = faces[3*f + s], b = faces[3*f + (s + 1) % 3];
+        edgeLevels[e] = edgeLevel(
+          &vertices[3 * std::min(a, b)], &vertices[3 * std::max(a, b)],
+          radius, O, tolerance / 4
+        );
+      }
+    }
+  }
+  parallelFor(nfaces, nthreads, [&](int begin, int end, int) {
+    FaceScratch threadScratch;
+    FaceScratch& fscratch = nthreads == 1 ? scratch : threadScratch;
+    for(int f = begin; f < end; f++) {
+      faceLevels[f] = faceLevel(
+        0, &vertices[3 * faces[3*f]], &vertices[3 * faces[3*f + 1]],
+        &vertices[3 * faces[3*f + 2]], nullptr, radius, O, tolerance,
+        fscratch
+      );
+    }
+  });
+  for(int f = 0; f < nfaces; f++) {
+    for(int s = 0; s < 3; s++) {
+      const int e = topology.faceEdges[3*f + s];
+      if(!border[e]) {
+        edgeLevels[e] = std::max(edgeLevels[e], faceLevels[f]);
+      }
+    }
+  }
+  parallelFor(nfaces, nthreads, [&](int begin, int end, int) {
+    FaceScratch threadScratch;
+    FaceScratch& fscratch = nthreads == 1 ? scratch : threadScratch;
+    for(int f = begin; f < end; f++) {
+      const int* e = &topology.faceEdges[3*f];
+      const int sideLevels[3] = {
+        edgeLevels[e[0]], edgeLevels[e[1]], edgeLevels[e[2]]
+      };
+      const int level = std::max(
+        faceLevels[f],
+        std::max(sideLevels[0], std::max(sideLevels[1], sideLevels[2]))
+      );
+      if(sideLevels[0] == level && sideLevels[1] == level &&
+         sideLevels[2] == level) {
+        faceLevels[f] = level;
+        continue;
+      }
+      faceLevels[f] = faceLevel(
+        level, &vertices[3 * faces[3*f]], &vertices[3 * faces[3*f + 1]],
+        &vertices[3 * faces[3*f + 2]], sideLevels, radius, O, tolerance,
+        fscratch
+      );
+    }
+  });
+  layoutOffsets(nvertices, topology, layout);
+}
+
+// places of the points and triangles in the mesh of an adaptive subdivision
+// whose levels are set
+void layoutOffsets(
+    int nvertices, const MeshTopology& topology, AdaptiveLayout& layout
+) {
+  const int nfaces = layout.faceLevels.size();
+  const int nedges = topology.nedges;
+  layout.edgePoints.resize(nedges + 1);
+  layout.edgePoints[0] = nvertices;
+  for(int e = 0; e < nedges; e++) {
+    layout.edgePoints[e + 1] =
+      layout.edgePoints[e] + (1 << layout.edgeLevels[e]) - 1;
+  }
+  // a face whose grid has n subdivisions and whose sides have n1, n2, n3
+  // arcs has (n-1)(n-2)/2 interior points and n1+n2+n3+(n-1)(n-2)-2
+  // triangles (Euler's formula)
+  layout.interiorPoints.resize(nfaces + 1);
+  layout.triangles.resize(nfaces + 1);
+  layout.interiorPoints[0] = layout.edgePoints[nedges];
+  layout.triangles[0] = 0;
+  for(int f = 0; f < nfaces; f++) {
+    const int n = 1 << layout.faceLevels[f];
+    const int* e = &topology.faceEdges[3*f];
+    const size_t nsides = (1 << layout.edgeLevels[e[0]]) +
+      (1 << layout.edgeLevels[e[1]]) + (1 << layout.edgeLevels[e[2]]);
+    layout.interiorPoints[f + 1] =
+      layout.interiorPoints[f] + (n - 1) * (n - 2) / 2;
+    layout.triangles[f + 1] =
+      layout.triangles[f] + nsides + size_t(n - 1) * (n - 2) - 2;
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// subdivides the f-th face of a triangulation according to its adaptive
+// layout, in a mesh sized from the layout; the grid of the face may be finer
+// than its sides, in which case the grid points of a side which are not
+// points of its edge are merged with the nearest ones (see mergeGrid) and
+// the triangles which become flat are dropped, so that the mesh is
+// conforming across the edges; only the points of the edges owned by the
+// face are written
+template <typename Sink>
+void subdivideFaceAdaptiveTo(
+    int f, const double* vertices, const int* faces,
+    const MeshTopology& topology, const AdaptiveLayout& layout,
+    double radius, const double* O, FaceScratch& scratch, const Sink& sink
+) {
+  const int level = layout.faceLevels[f];
+  const int n = 1 << level;
+  const int npointsGrid = gridSize(n);
+  scratch.grid.resize(3 * npointsGrid);
+  scratch.global.resize(npointsGrid);
+  scratch.merged.resize(npointsGrid);
+  scratch.local.resize(3 * n * n);
+  double* x = scratch.grid.data();
+  double* y = x + npointsGrid;
+  double* z = y + npointsGrid;
+  int* global = scratch.global.data();
+  int* merged = scratch.merged.data();
+  const int corners[3] = {faces[3*f], faces[3*f + 1], faces[3*f + 2]};
+  const int* faceEdges = &topology.faceEdges[3*f];
+  const int arcs[3] = {
+    1 << layout.edgeLevels[faceEdges[0]],
+    1 << layout.edgeLevels[faceEdges[1]],
+    1 << layout.edgeLevels[faceEdges[2]]
+  };
+  subdivideTriangle(
+    level, &vertices[3 * corners[0]], &vertices[3 * corners[1]],
+    &vertices[3 * corners[2]], radius, O, x, y, z
+  );
+  mergeGrid(n, arcs, merged);
+  global[gridIndex(n, 0, 0)] = corners[0];
+  global[gridIndex(n, n, 0)] = corners[1];
+  global[gridIndex(n, 0, n)] = corners[2];
+  // points of the edges, ordered from the vertex with the lowest index
+  const char* owner = &topology.owner[3*f];
+  for(int s = 0; s < 3; s++) {
+    const int a = corners[s], b = corners[(s + 1) % 3];
+    const int m = n / arcs[s];
+    const int first = int(layout.edgePoints[faceEdges[s]]) - 1;
+    for(int u = 1; u < arcs[s]; u++) {
+      const int l = sidePoint(n, s, u * m);
+      global[l] = first + (a < b ? u : arcs[s] - u);
+      if(owner[s]) {
+        sink.point(global[l], x[l], y[l], z[l]);
+      }
+    }
+  }
+  for(int s = 0; s < 3; s++) {
+    for(int t = 1; t < n; t++) {
+      const int l = sidePoint(n, s, t);
+      global[l] = global[merged[l]];
+    }
+  }
+  // interior
+  size_t k = layout.interiorPoints[f];
+  for(int j = 1; j < n - 1; j++) {
+    for(int i = 1; i + j < n; i++) {
+      const int l = gridIndex(n, i, j);
+      global[l] = int(k);
+      sink.point(k, x[l], y[l], z[l]);
+      k++;
+    }
+  }
+  // triangles
+  gridTriangles(n, scratch.local.data(), 0);
+  sink.face(
+    f, layout.triangles[f], layout.triangles[f + 1] - layout.triangles[f]
+  );
+  int* triangles = sink.triangles(layout.triangles[f]);
+  const int* local = scratch.local.data();
+  for(int t = 0; t < n * n; t++, local += 3) {
+    const int p = global[local[0]], q = global[local[1]],
+              r = global[local[2]];
+    if(p != q && q != r && r != p) {
+      *triangles++ = p + Sink::shift;
+      *triangles++ = q + Sink::shift;
+      *triangles++ = r + Sink::shift;
+    }
+  }
+}
+
+void subdivideFaceAdaptive(
+    int f, const double* vertices, const int* faces,
+    const MeshTopology& topology, const AdaptiveLayout& layout,
+    double radius, const double* O, FaceScratch& scratch, SMesh& smesh
+) {
+  subdivideFaceAdaptiveTo(
+    f, vertices, faces, topology, layout, radius, O, scratch,
+    SMeshSink{smesh}
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// subdivides each face of a spherical triangulation until its triangles are
+// within `tolerance` of the sphere, each point being computed and stored
+// only once; the faces are subdivided with `nthreads` threads
+SMesh subdivideMeshAdaptive(
+    const std::vector<double>& vertices, const std::vector<int>& faces,
+    double tolerance, double radius, const double* O, int nthreads
+) {
+  const int nvertices = vertices.size() / 3;
+  const int nfaces = faces.size() / 3;
+  MeshTopology topology;
+  edgeTopology(faces, topology);
+  AdaptiveLayout layout;
+  FaceScratch scratch;
+  adaptiveLayout(
+    vertices.data(), nvertices, faces, topology, radius, O, tolerance,
+    nthreads, scratch, layout
+  );
+  SMesh smesh;
+  smesh.vertices.resize(3 * layout.interiorPoints[nfaces]);
+  smesh.faces.resize(3 * layout.triangles[nfaces]);
+  smesh.offsets.resize(nfaces + 1);
+  std::copy(vertices.begin(), vertices.end(), smesh.vertices.begin());
+  parallelFor(nfaces, nthreads, [&](int begin, int end, int) {
+    FaceScratch scratch;
+    for(int f = begin; f < end; f++) {
+      subdivideFaceAdaptive(
+        f, vertices.data(), faces.data(), topology, layout,
+        radius, O, scratch, smesh
+      );
+    }
+  });
+  smesh.offsets[nfaces] = layout.triangles[nfaces];
+  return smesh;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// subdivision of a triangulation as subdivideMesh, or subdivideMeshAdaptive if
+// `layout` is not null, written directly in the buffers of `packed`, sized
+// with meshSize or from the layout; the topology is the one of the faces; the
+// returned value is the number of bytes of the scratch buffers of the threads
+size_t subdividePacked(
+    const std::vector<double>& vertices, const std::vector<int>& faces,
+    const MeshTopology& topology, int level, const AdaptiveLayout* layout,
+    double radius, const double* O, int nthreads, const PackedMesh& packed
+) {
+  const int nvertices = vertices.size() / 3;
+  const int nfaces = faces.size() / 3;
+  const PackedSink sink{packed, O};
+  for(int i = 0; i < nvertices; i++) {
+    sink.point(i, vertices[3*i], vertices[3*i + 1], vertices[3*i + 2]);
+  }
+  // bytes of the scratch buffers, summed by thread
+  std::vector<size_t> scratchBytes(std::max(1, nthreads), 0);
+  if(layout) {
+    parallelFor(nfaces, nthreads, [&](int begin, int end, int thread) {
+      FaceScratch scratch;
+      for(int f = begin; f < end; f++) {
+        subdivideFaceAdaptiveTo(
+          f, vertices.data(), faces.data(), topology, *layout, radius, O,
+          scratch, sink
+        );
+      }
+      scratchBytes[thread] += bufferBytes(scratch);
+    });
+    if(packed.offsets) {
+      packed.offsets[nfaces] = int(layout->triangles[nfaces]);
+    }
+    return std::accumulate(scratchBytes.begin(), scratchBytes.end(), size_t(0));
+  }
+  const int n = 1 << level;
+  std::vector<int> local(3 * n * n);
+  triangleFaces(level, local.data(), 0);
+  parallelFor(nfaces, nthreads, [&](int begin, int end, int thread) {
+    FaceScratch scratch;
+    for(int f = begin; f < end; f++) {
+      subdivideFaceTo(
+        f, vertices.data(), nvertices, faces.data(), topology, level, radius,
+        O, local.data(), scratch, sink
+      );
+    }
+    scratchBytes[thread] += bufferBytes(scratch);
+  });
+  if(packed.offsets) {
+    packed.offsets[nfaces] = nfaces * n * n;
+  }
+  return bufferBytes(local) +
+    std::accumulate(scratchBytes.begin(), scratchBytes.end(), size_t(0));
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// subdivision of a triangulation as subdivideMesh, or subdivideMeshAdaptive if
+// `tolerance` is positive, with a single thread, written in `smesh` and using
+// the topology, the layout and the buffers of `scratch`, which all keep their
+// capacities when they are reused from one triangulation to the next
+void subdivideMeshScratch(
+    const std::vector<double>& vertices, const std::vector<int>& faces,
+    int level, double tolerance, double radius, const double* O,
+    FaceScratch& scratch, SMesh& smesh
+) {
+  const int nvertices = vertices.size() / 3;
+  const int nfaces = faces.size() / 3;
+  MeshTopology& topology = scratch.topology;
+  edgeTopology(faces, topology);
+  if(tolerance > 0) {
+    AdaptiveLayout& layout = scratch.layout;
+    adaptiveLayout(
+      vertices.data(), nvertices, faces, topology, radius, O, tolerance, 1,
+      scratch, layout
+    );
+    smesh.vertices.resize(3 * layout.interiorPoints[nfaces]);
+    smesh.faces.resize(3 * layout.triangles[nfaces]);
+    smesh.offsets.resize(nfaces + 1);
+    std::copy(vertices.begin(), vertices.end(), smesh.vertices.begin());
+    for(int f = 0; f < nfaces; f++) {
+      subdivideFaceAdaptive(
+        f, vertices.data(), faces.data(), topology, layout,
+        radius, O, scratch, smesh
+      );
+    }
+    smesh.offsets[nfaces] = layout.triangles[nfaces];
+    return;
+  }
+  const int n = 1 << level;
+  allocateMesh(nvertices, topology.nedges, nfaces, level, smesh);
+  std::copy(vertices.begin(), vertices.end(), smesh.vertices.begin());
+  // subdivideFace only uses the grid buffers of the scratch space
+  scratch.local.resize(3 * n * n);
+  triangleFaces(level, scratch.local.data(), 0);
+  for(int f = 0; f < nfaces; f++) {
+    subdivideFace(
+      f, vertices.data(), nvertices, faces.data(), topology, level, radius,
+      O, scratch.local.data(), scratch, smesh
+    );
+  }
+  smesh.offsets[nfaces] = nfaces * n * n;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// levels of the adaptive subdivision of the star triangulation of a spherical
+// polygon (see subdivideStar), computed in the topology and the layout of
+// `scratch`; the sides of the polygon are divided according to their lengths
+// only, so two polygons sharing a side divide it at the same points
+void starLayout(
+    const double* points, int ncorners, double tolerance, double radius,
+    const double* O, FaceScratch& scratch
+) {
+  starTopology(ncorners, scratch.faces, scratch.topology);
+  adaptiveLayout(
+    points, ncorners + 1, scratch.faces, scratch.topology, radius, O,
+    tolerance, 1, scratch, scratch.layout
+  );
+}
+
+// subdivides the star triangulation of a spherical polygon according to the
+// topology and the layout of `scratch`
+void fillStar(
+    const double* points, int ncorners, double radius, const double* O,
+    FaceScratch& scratch, SMesh& smesh
+) {
+  const int nfaces = ncorners;
+  const AdaptiveLayout& layout = scratch.layout;
+  smesh.vertices.resize(3 * layout.interiorPoints[nfaces]);
+  smesh.faces.resize(3 * layout.triangles[nfaces]);
+  smesh.offsets.resize(nfaces + 1);
+  std::copy(points, points + 3 * (ncorners + 1), smesh.vertices.begin());
+  for(int f = 0; f < nfaces; f++) {
+    subdivideFaceAdaptive(
+      f, points, scratch.faces.data(), scratch.topology, layout, radius, O,
+      scratch, smesh
+    );
+  }
+  smesh.offsets[nfaces] = layout.triangles[nfaces];
+}
+
+// adaptive subdivision of the star triangulation of a spherical polygon, as
+// subdivideMeshAdaptive
+void subdivideStarAdaptive(
+    const double* points, int ncorners, double tolerance, double radius,
+    const double* O, FaceScratch& scratch, SMesh& smesh
+) {
+  starLayout(points, ncorners, tolerance, radius, O, scratch);
+  fillStar(points, ncorners, radius, O, scratch, smesh);
+}
+
+// adaptive subdivision of the star triangulation of a spherical polygon with
+// the levels of its 2*ncorners edges and its ncorners faces computed
+// beforehand by starLayout
+void subdivideStarLevels(
+    const double* points, int ncorners, const int* edgeLevels,
+    const int* faceLevels, double radius, const double* O,
+    FaceScratch& scratch, SMesh& smesh
+) {
+  AdaptiveLayout& layout = scratch.layout;
+  starTopology(ncorners, scratch.faces, scratch.topology);
+  layout.edgeLevels.assign(edgeLevels, edgeLevels + 2 * ncorners);
+  layout.faceLevels.assign(faceLevels, faceLevels + ncorners);
+  layoutOffsets(ncorners + 1, scratch.topology, layout);
+  fillStar(points, ncorners, radius, O, scratch, smesh);
+}
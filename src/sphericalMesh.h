@@ -0,0 +1,367 @@
+#ifndef __SPHERICALMESH_HEADER__
+#define __SPHERICALMESH_HEADER__
+
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "simd.h"
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Mesh of the subdivided spherical triangles of a triangulation. Vertices are
+// stored as consecutive (x, y, z) triplets and faces as consecutive triplets
+// of zero-based vertex indices. The triangles coming from the f-th face of the
+// triangulation are the ones from offsets[f] to offsets[f+1]-1.
+struct SMesh {
+  std::vector<double> vertices;
+  std::vector<int>    faces;
+  std::vector<int>    offsets;
+};
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Edges of a triangulation: faceEdges[3*f+s] is the index of the s-th side of
+// the f-th face (sides AB, BC, CA) and owner[3*f+s] tells whether this face is
+// the one storing the points of this edge.
+struct MeshTopology {
+  std::vector<int>  faceEdges;
+  std::vector<char> owner;
+  int               nedges;
+};
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Adaptive subdivision of a triangulation: the e-th edge is divided into
+// 2^edgeLevels[e] arcs and the grid of the f-th face has 2^faceLevels[f]
+// subdivisions along each side, faceLevels[f] being at least the levels of
+// the sides of the face. The points inside the e-th edge are stored from
+// edgePoints[e], the points inside the f-th face from interiorPoints[f], and
+// the triangles of the f-th face start at triangles[f].
+struct AdaptiveLayout {
+  std::vector<int>    edgeLevels;
+  std::vector<int>    faceLevels;
+  std::vector<size_t> edgePoints;
+  std::vector<size_t> interiorPoints;
+  std::vector<size_t> triangles;
+};
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Levels of detail of a subdivided triangulation: the l-th level uses the
+// first nvertices[l] vertices of the mesh and its triangles are faces[l],
+// except for the finest level whose triangles are the ones of the mesh.
+struct MeshPyramid {
+  std::vector<size_t>           nvertices;
+  std::vector<std::vector<int>> faces;
+};
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Render-ready buffers (see packMesh) in which subdividePacked writes a mesh
+// without building it first: six numbers per point in `vertices`, its
+// coordinates and its normal, or, if `vertices` is null, its coordinates as
+// three single-precision numbers in `positions`; three one-based vertex
+// indices per triangle in `indices`; the one-based index of the face of each
+// triangle in `ids` and the offsets of the triangles of the faces in
+// `offsets`, each of them unless it is null.
+struct PackedMesh {
+  double* vertices;
+  float*  positions;
+  int*    indices;
+  int*    ids;
+  int*    offsets;
+};
+
+// largest level of the adaptive subdivision
+const int maxAdaptiveLevel = 10;
+
+// scratch space for the subdivision of the faces of a triangulation, meant to
+// be reused from one face or one triangulation to the next
+struct FaceScratch {
+  std::vector<double> grid;
+  std::vector<int>    global;
+  std::vector<int>    faces;
+  std::vector<int>    local;
+  std::vector<int>    merged;
+  MeshTopology        topology;
+  AdaptiveLayout      layout;
+};
+
+// bytes held by the buffers of a vector or of one of the structures above,
+// from their capacities; used by the profiles of the exported functions
+template <typename T>
+inline size_t bufferBytes(const std::vector<T>& v) {
+  return v.capacity() * sizeof(T);
+}
+
+inline size_t bufferBytes(const SMesh& smesh) {
+  return bufferBytes(smesh.vertices) + bufferBytes(smesh.faces) +
+    bufferBytes(smesh.offsets);
+}
+
+inline size_t bufferBytes(const MeshTopology& topology) {
+  return bufferBytes(topology.faceEdges) + bufferBytes(topology.owner);
+}
+
+inline size_t bufferBytes(const AdaptiveLayout& layout) {
+  return bufferBytes(layout.edgeLevels) + bufferBytes(layout.faceLevels) +
+    bufferBytes(layout.edgePoints) + bufferBytes(layout.interiorPoints) +
+    bufferBytes(layout.triangles);
+}
+
+inline size_t bufferBytes(const MeshPyramid& pyramid) {
+  size_t bytes = bufferBytes(pyramid.nvertices) + bufferBytes(pyramid.faces);
+  for(const std::vector<int>& faces : pyramid.faces) {
+    bytes += bufferBytes(faces);
+  }
+  return bytes;
+}
+
+inline size_t bufferBytes(const FaceScratch& scratch) {
+  return bufferBytes(scratch.grid) + bufferBytes(scratch.global) +
+    bufferBytes(scratch.faces) + bufferBytes(scratch.local) +
+    bufferBytes(scratch.merged) + bufferBytes(scratch.topology) +
+    bufferBytes(scratch.layout);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// A triangle ABC subdivided n times along each side is a triangular grid;
+// the point (i, j), i+j <= n, has barycentric weights (n-i-j, i, j) so
+// that A = (0, 0), B = (n, 0) and C = (0, n); the points are stored row by
+// row (increasing j)
+inline int gridIndex(int n, int i, int j) {
+  return j * (n + 1) - j * (j - 1) / 2 + i;
+}
+
+inline int gridSize(int n) {
+  return (n + 1) * (n + 2) / 2;
+}
+
+// numbers of vertices and triangles of the mesh of a star of `ncorners`
+// corners subdivided n times along each side, as built by subdivideStar;
+// they are computed in 64 bits so that the callers can compare their sums
+// to INT_MAX
+inline uint64_t starMeshVertices(uint64_t ncorners, uint64_t n) {
+  return ncorners + 1 + 2 * ncorners * (n - 1) +
+    ncorners * ((n - 1) * (n - 2) / 2);
+}
+
+inline uint64_t starMeshTriangles(uint64_t ncorners, uint64_t n) {
+  return ncorners * n * n;
+}
+
+// the largest level of subdivision of a mesh whose indices fit in an int:
+// beyond it, a single triangle subdivided n = 2^level times along each side
+// has more than INT_MAX/3 triangles
+const int maxMeshLevel = 14;
+
+// number of subdivisions of a side after `level` quadrisections, as a
+// compile-time constant
+template <int level>
+using Subdivisions = std::integral_constant<int, 1 << level>;
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// The inlined subdivision must give the same points as the kernels of
+// simd.cpp, so the fused multiply-adds are disabled here as well, whatever
+// the compiler options (-march=native for instance).
+#if defined(__clang__)
+#define MIDPOINT_NO_CONTRACT _Pragma("clang fp contract(off)")
+#else
+#define MIDPOINT_NO_CONTRACT
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// projection on the sphere (center O) of the midpoint of the grid points p
+// and q, stored at m; the coordinates are stored in three separate arrays
+inline void sphericalMidpoint(
+    double* x, double* y, double* z, int p, int q, int m,
+    double radius, const double* O
+) {
+  MIDPOINT_NO_CONTRACT
+  const double mx = 0.5 * (x[p] + x[q]) - O[0];
+  const double my = 0.5 * (y[p] + y[q]) - O[1];
+  const double mz = 0.5 * (z[p] + z[q]) - O[2];
+  const double scale = radius / sqrt(mx*mx + my*my + mz*mz);
+  x[m] = O[0] + scale * mx;
+  y[m] = O[1] + scale * my;
+  z[m] = O[2] + scale * mz;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Fills the grid of the spherical triangle ABC, that is the last level of the
+// repeated quadrisections of ABC. A point introduced at a given level is the
+// spherical midpoint of two points of the previous level, so the points of a
+// side of the triangle only depend on the two vertices of this side. The
+// arrays x, y and z must have gridSize(n) elements. `Size` is either `int`
+// or a `std::integral_constant`, in which case all loop bounds are known at
+// compile time.
+template <typename Size>
+inline void subdivideGrid(
+    Size n, const double* A, const double* B, const double* C,
+    double radius, const double* O, double* x, double* y, double* z
+) {
+  const int a = gridIndex(n, 0, 0), b = gridIndex(n, n, 0),
+            c = gridIndex(n, 0, n);
+  x[a] = A[0]; y[a] = A[1]; z[a] = A[2];
+  x[b] = B[0]; y[b] = B[1]; z[b] = B[2];
+  x[c] = C[0]; y[c] = C[1]; z[c] = C[2];
+  for(int s = n / 2; s >= 1; s /= 2) {
+    // points with an odd i and an even j
+    for(int j = 0; j < n; j += 2*s) {
+      for(int i = s; i + j < n; i += 2*s) {
+        sphericalMidpoint(
+          x, y, z, gridIndex(n, i - s, j), gridIndex(n, i + s, j),
+          gridIndex(n, i, j), radius, O
+        );
+      }
+    }
+    // points with an odd j
+    for(int j = s; j < n; j += 2*s) {
+      // even i
+      for(int i = 0; i + j < n; i += 2*s) {
+        sphericalMidpoint(
+          x, y, z, gridIndex(n, i, j - s), gridIndex(n, i, j + s),
+          gridIndex(n, i, j), radius, O
+        );
+      }
+      // odd i
+      for(int i = s; i + j <= n; i += 2*s) {
+        sphericalMidpoint(
+          x, y, z, gridIndex(n, i + s, j - s), gridIndex(n, i - s, j + s),
+          gridIndex(n, i, j), radius, O
+        );
+      }
+    }
+  }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// the n*n triangles of the grid, as triplets of grid indices plus `base`; they
+// have the orientation of ABC
+template <typename Size>
+inline void gridTriangles(Size n, int* triangles, int base) {
+  for(int j = 0; j < n; j++) {
+    for(int i = 0; i + j < n; i++) {
+      *triangles++ = gridIndex(n, i, j) + base;
+      *triangles++ = gridIndex(n, i + 1, j) + base;
+      *triangles++ = gridIndex(n, i, j + 1) + base;
+      if(i + j < n - 1) {
+        *triangles++ = gridIndex(n, i + 1, j) + base;
+        *triangles++ = gridIndex(n, i + 1, j + 1) + base;
+        *triangles++ = gridIndex(n, i, j + 1) + base;
+      }
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+void subdivideTriangle(
+  int, const double*, const double*, const double*, double, const double*,
+  double*, double*, double*
+);
+
+void streamGrid(
+  int, const double*, const double*, const double*, double, const double*,
+  double*, double*, double*, MidpointsKernel
+);
+
+void triangleFaces(int, int*, int);
+
+void edgeTopology(const std::vector<int>&, MeshTopology&);
+
+void meshSize(int, int, int, int, size_t&, size_t&);
+
+void allocateMesh(int, int, int, int, SMesh&);
+
+void subdivideFace(
+  int, const double*, int, const int*, const MeshTopology&, int, double,
+  const double*, const int*, FaceScratch&, SMesh&
+);
+
+SMesh subdivideMesh(
+  const std::vector<double>&, const std::vector<int>&, int, double,
+  const double*, int
+);
+
+void faceGrid(int, int, int, const int*, const MeshTopology&, int*);
+
+void meshPyramid(
+  int, const std::vector<int>&, const MeshTopology&, int, int, SMesh&,
+  MeshPyramid&
+);
+
+void subdivideStar(
+  const double*, int, int, double, const double*, const int*, FaceScratch&,
+  SMesh&
+);
+
+void packMesh(const SMesh&, const double*, size_t, size_t, double*, int*);
+
+void packMeshCompact(const SMesh&, size_t, size_t, float*, int*);
+
+void packTriangles(const SMesh&, size_t, size_t, int*);
+
+int edgeLevel(const double*, const double*, double, const double*, double);
+
+int faceLevel(
+  int, const double*, const double*, const double*, const int*, double,
+  const double*, double, FaceScratch&
+);
+
+void adaptiveLayout(
+  const double*, int, const std::vector<int>&, const MeshTopology&, double,
+  const double*, double, int, FaceScratch&, AdaptiveLayout&
+);
+
+void subdivideFaceAdaptive(
+  int, const double*, const int*, const MeshTopology&,
+  const AdaptiveLayout&, double, const double*, FaceScratch&, SMesh&
+);
+
+SMesh subdivideMeshAdaptive(
+  const std::vector<double>&, const std::vector<int>&, double, double,
+  const double*, int
+);
+
+void layoutOffsets(int, const MeshTopology&, AdaptiveLayout&);
+
+size_t subdividePacked(
+  const std::vector<double>&, const std::vector<int>&, const MeshTopology&,
+  int, const AdaptiveLayout*, double, const double*, int, const PackedMesh&
+);
+
+void subdivideMeshScratch(
+  const std::vector<double>&, const std::vector<int>&, int, double, double,
+  const double*, FaceScratch&, SMesh&
+);
+
+void starLayout(
+  const double*, int, double, double, const double*, FaceScratch&
+);
+
+void subdivideStarAdaptive(
+  const double*, int, double, double, const double*, FaceScratch&, SMesh&
+);
+
+void subdivideStarLevels(
+  const double*, int, const int*, const int*, double, const double*,
+  FaceScratch&, SMesh&
+);
+
+#endif
@@ -0,0 +1,755 @@
+#include "sphereTessellation.h"
+#include <set>
+#include <unordered_set>
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// vertex of the site with identifier `id`
+DToS::Vertex_handle siteVertex(const Tessellation& tess, int id) {
+  if(id == NA_INTEGER || id < 1 || id > int(tess.handles.size()) ||
+     tess.handles[id - 1] == DToS::Vertex_handle()) {
+    Rcpp::stop("Invalid site identifier: " + std::to_string(id) + ".");
+  }
+  return tess.handles[id - 1];
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// records that the Voronoï cell of the site `id` may have changed, and drops
+// its cached mesh
+void touchSite(Tessellation& tess, int id) {
+  tess.cellMeshes.erase(id);
+  if(!tess.isModified[id - 1]) {
+    tess.isModified[id - 1] = true;
+    tess.modified.push_back(id);
+  }
+}
+
+// records that the Voronoï cells of v and of its neighbors may have changed;
+// these are the cells affected by the insertion or the removal of v; all
+// cells are affected when the triangulation is not two-dimensional
+void touchStar(Tessellation& tess, DToS::Vertex_handle v) {
+  if(tess.dtos.dimension() < 2) {
+    for(auto vh : tess.dtos.vertex_handles()) {
+      touchSite(tess, vh->info());
+    }
+    return;
+  }
+  touchSite(tess, v->info());
+  const DToS::Vertex_circulator done = tess.dtos.incident_vertices(v);
+  DToS::Vertex_circulator vc = done;
+  do {
+    touchSite(tess, vc->info());
+  } while(++vc != done);
+}
+
+// caches the mesh of the Delaunay face whose vertices have the sorted
+// identifiers `key`, and indexes it by these sites
+SMesh& cacheFaceMesh(
+    Tessellation& tess, const std::array<int, 3>& key, SMesh&& smesh
+) {
+  const auto inserted = tess.faceMeshes.emplace(key, std::move(smesh));
+  if(inserted.second) {
+    for(const int id : key) {
+      tess.siteFaces[id].push_back(key);
+    }
+  }
+  return inserted.first->second;
+}
+
+// drops the cached mesh of a Delaunay face and its key from the index
+void forgetFace(Tessellation& tess, const std::array<int, 3>& key) {
+  tess.faceMeshes.erase(key);
+  for(const int id : key) {
+    const auto it = tess.siteFaces.find(id);
+    if(it == tess.siteFaces.end()) {
+      continue;
+    }
+    std::vector<std::array<int, 3>>& keys = it->second;
+    keys.erase(std::remove(keys.begin(), keys.end(), key), keys.end());
+    if(keys.empty()) {
+      tess.siteFaces.erase(it);
+    }
+  }
+}
+
+// drops the cached meshes of the Delaunay faces having the site `id` as a
+// vertex, which change when this site is moved or removed; the other faces
+// keep their meshes, since a face with the same vertices is the same
+// spherical triangle
+void forgetSite(Tessellation& tess, int id) {
+  const auto it = tess.siteFaces.find(id);
+  if(it == tess.siteFaces.end()) {
+    return;
+  }
+  const std::vector<std::array<int, 3>> keys = it->second;
+  for(const std::array<int, 3>& key : keys) {
+    forgetFace(tess, key);
+  }
+}
+
+// whether the sites with the identifiers `key` are the vertices of a face
+bool isFace(const Tessellation& tess, const std::array<int, 3>& key) {
+  const DToS::Vertex_handle v = tess.handles[key[0] - 1];
+  if(v == DToS::Vertex_handle()) {
+    return false;
+  }
+  const DToS::Face_circulator done = tess.dtos.incident_faces(v);
+  DToS::Face_circulator fc = done;
+  do {
+    std::array<int, 3> vertices;
+    for(int i = 0; i < 3; i++) {
+      vertices[i] = fc->vertex(i)->info();
+    }
+    std::sort(vertices.begin(), vertices.end());
+    if(vertices == key) {
+      return true;
+    }
+  } while(++fc != done);
+  return false;
+}
+
+// drops the cached meshes of the Delaunay faces destroyed by the insertion of
+// the vertex v, whose vertices are neighbors of v; all of them are dropped
+// when the triangulation is not two-dimensional; after the insertion of
+// several points, a destroyed face may have no vertex adjacent to a new one,
+// and its mesh is dropped by trimFaceMeshes
+void forgetConflicts(Tessellation& tess, DToS::Vertex_handle v) {
+  if(tess.dtos.dimension() < 2) {
+    tess.faceMeshes.clear();
+    tess.siteFaces.clear();
+    return;
+  }
+  std::vector<std::array<int, 3>> destroyed;
+  const DToS::Vertex_circulator done = tess.dtos.incident_vertices(v);
+  DToS::Vertex_circulator vc = done;
+  do {
+    const auto it = tess.siteFaces.find(vc->info());
+    if(it == tess.siteFaces.end()) {
+      continue;
+    }
+    for(const std::array<int, 3>& key : it->second) {
+      if(!isFace(tess, key)) {
+        destroyed.push_back(key);
+      }
+    }
+  } while(++vc != done);
+  for(const std::array<int, 3>& key : destroyed) {
+    forgetFace(tess, key);
+  }
+}
+
+// drops the cached meshes of the destroyed Delaunay faces once the cache holds
+// twice as many meshes as the triangulation has faces, which bounds its size
+void trimFaceMeshes(Tessellation& tess) {
+  if(tess.faceMeshes.size() <= 2 * tess.dtos.number_of_faces()) {
+    return;
+  }
+  std::vector<std::array<int, 3>> destroyed;
+  for(const auto& entry : tess.faceMeshes) {
+    if(!isFace(tess, entry.first)) {
+      destroyed.push_back(entry.first);
+    }
+  }
+  for(const std::array<int, 3>& key : destroyed) {
+    forgetFace(tess, key);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// inserts the points (columns of `pts`) and returns the identifiers of their
+// sites, NA for the points which are already sites; the cells of the sites
+// which are finally adjacent to a new site are the ones which have changed
+Rcpp::IntegerVector insertSites(
+    Tessellation& tess, const Rcpp::NumericMatrix pts
+) {
+  std::vector<PointOnSphere> spoints;
+  std::vector<SPoint3> projections;
+  projectPoints(tess.dtos.geom_traits(), pts, spoints, projections);
+  const int npoints = spoints.size();
+  const int firstid = tess.handles.size() + 1;
+  const std::vector<DToS::Vertex_handle> vhs = insertPoints(
+    tess.dtos, spoints, projections, npoints >= 1000, firstid
+  );
+  tess.handles.insert(tess.handles.end(), vhs.begin(), vhs.end());
+  tess.isModified.resize(tess.handles.size(), false);
+  Rcpp::IntegerVector Ids(npoints);
+  for(int i = 0; i < npoints; i++) {
+    if(vhs[i] == DToS::Vertex_handle()) {
+      Ids(i) = NA_INTEGER;
+    } else {
+      Ids(i) = firstid + i;
+      touchStar(tess, vhs[i]);
+      forgetConflicts(tess, vhs[i]);
+    }
+  }
+  return Ids;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// removes the site `id`; the cells of its neighbors are the ones which change
+void removeSite(Tessellation& tess, int id) {
+  const DToS::Vertex_handle v = siteVertex(tess, id);
+  touchStar(tess, v);
+  forgetSite(tess, id);
+  tess.dtos.remove(v);
+  tess.handles[id - 1] = DToS::Vertex_handle();
+  tess.removed.push_back(id);
+  if(tess.dtos.dimension() < 2) {
+    for(auto vh : tess.dtos.vertex_handles()) {
+      touchSite(tess, vh->info());
+    }
+    tess.faceMeshes.clear();
+    tess.siteFaces.clear();
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// moves the site `id` to the point p; the site keeps its identifier, and a
+// move to a point too close to its current position does nothing; returns
+// false, without any change, if p is too close to another site
+bool moveSite(Tessellation& tess, int id, const PointOnSphere& p) {
+  const DToS::Vertex_handle v = siteVertex(tess, id);
+  DToS::Locate_type lt;
+  int li;
+  const DToS::Face_handle fh = tess.dtos.locate(p, lt, li);
+  if(lt == DToS::VERTEX || lt == DToS::TOO_CLOSE) {
+    return fh->vertex(li) == v;
+  }
+  touchStar(tess, v);
+  forgetSite(tess, id);
+  tess.dtos.remove(v);
+  const DToS::Vertex_handle vh = tess.dtos.insert(p);
+  vh->info() = id;
+  tess.handles[id - 1] = vh;
+  touchStar(tess, vh);
+  forgetConflicts(tess, vh);
+  return true;
+}
+
+// checks the identifiers of a batch of sites before any of them is modified,
+// so that an invalid or duplicated identifier leaves the tessellation as is
+void checkBatch(const Tessellation& tess, const Rcpp::IntegerVector ids) {
+  std::unordered_set<int> seen;
+  for(const int id : ids) {
+    siteVertex(tess, id);
+    if(!seen.insert(id).second) {
+      Rcpp::stop("Duplicated site identifier: " + std::to_string(id) + ".");
+    }
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// [[Rcpp::export]]
+Rcpp::XPtr<Tessellation> tessellation_new(
+    Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O
+) {
+  const Traits ball(SPoint3(O(0), O(1), O(2)), radius);
+  Rcpp::XPtr<Tessellation> xptr(new Tessellation(ball), true);
+  insertSites(*xptr, pts);
+  // everything is new, there is nothing to report
+  Tessellation& tess = *xptr;
+  for(const int id : tess.modified) {
+    tess.isModified[id - 1] = false;
+  }
+  tess.modified.clear();
+  return xptr;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// [[Rcpp::export]]
+Rcpp::IntegerVector tessellation_insert(
+    Rcpp::XPtr<Tessellation> xptr, Rcpp::NumericMatrix pts
+) {
+  return insertSites(*xptr, pts);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// [[Rcpp::export]]
+void tessellation_remove(
+    Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids
+) {
+  Tessellation& tess = *xptr;
+  checkBatch(tess, ids);
+  for(const int id : ids) {
+    removeSite(tess, id);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// [[Rcpp::export]]
+void tessellation_move(
+    Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids,
+    Rcpp::NumericMatrix pts
+) {
+  Tessellation& tess = *xptr;
+  std::vector<PointOnSphere> spoints;
+  std::vector<SPoint3> projections;
+  projectPoints(tess.dtos.geom_traits(), pts, spoints, projections);
+  checkBatch(tess, ids);
+  // whether a point is too close to another site is only known when its site
+  // is moved, so if a move fails, the previous ones are undone in reverse
+  // order and the sites they have reported as modified are forgotten
+  const size_t nmodified = tess.modified.size();
+  std::vector<PointOnSphere> previous;
+  previous.reserve(ids.size());
+  for(int i = 0; i < ids.size(); i++) {
+    previous.push_back(tess.handles[ids(i) - 1]->point());
+    if(moveSite(tess, ids(i), spoints[i])) {
+      continue;
+    }
+    for(int j = i - 1; j >= 0; j--) {
+      moveSite(tess, ids(j), previous[j]);
+    }
+    for(size_t k = nmodified; k < tess.modified.size(); k++) {
+      tess.isModified[tess.modified[k] - 1] = false;
+    }
+    tess.modified.resize(nmodified);
+    Rcpp::stop(
+      "Cannot move the site " + std::to_string(ids(i)) +
+      ": the point is too close to an existing site."
+    );
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// identifiers and coordinates of the sites
+// [[Rcpp::export]]
+Rcpp::List tessellation_sites(Rcpp::XPtr<Tessellation> xptr) {
+  const Tessellation& tess = *xptr;
+  const Traits& ball = tess.dtos.geom_traits();
+  const int nsites = tess.dtos.number_of_vertices();
+  Rcpp::IntegerVector Ids(nsites);
+  Rcpp::NumericMatrix Sites(nsites, 3);
+  int k = 0;
+  for(int i = 0; i < int(tess.handles.size()); i++) {
+    const DToS::Vertex_handle vh = tess.handles[i];
+    if(vh == DToS::Vertex_handle()) {
+      continue;
+    }
+    const SPoint3 p = vh->point().get_projection(ball.center(), ball.radius());
+    Ids(k) = i + 1;
+    Sites(k, 0) = p.x();
+    Sites(k, 1) = p.y();
+    Sites(k, 2) = p.z();
+    k++;
+  }
+  return Rcpp::List::create(
+    Rcpp::Named("ids")   = Ids,
+    Rcpp::Named("sites") = Sites
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Voronoï cell of the vertex v, computed from its star: the coordinates of
+// its vertices, in counterclockwise order, and the identifiers of the sites
+// of its neighbors
+void siteCell(
+    const DToS& dtos, const DToS::Vertex_handle v, std::vector<double>& cell,
+    std::vector<int>& neighbors
+) {
+  cell.clear();
+  neighbors.clear();
+  const DToS::Face_circulator done = dtos.incident_faces(v);
+  DToS::Face_circulator fc = done;
+  do {
+    const SPoint3 p = dtos.dual_on_sphere(fc);
+    cell.push_back(p.x());
+    cell.push_back(p.y());
+    cell.push_back(p.z());
+    neighbors.push_back(fc->vertex(dtos.cw(fc->index(v)))->info());
+  } while(++fc != done);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Voronoï cells of the given sites, computed from their stars only
+// [[Rcpp::export]]
+Rcpp::List tessellation_cells(
+    Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids
+) {
+  const Tessellation& tess = *xptr;
+  const DToS& dtos = tess.dtos;
+  if(dtos.dimension() < 2) {
+    Rcpp::stop("The triangulation is not two-dimensional.");
+  }
+  const Traits& ball = dtos.geom_traits();
+  const int nids = ids.size();
+  Rcpp::List Cells(nids);
+  for(int k = 0; k < nids; k++) {
+    const DToS::Vertex_handle v = siteVertex(tess, ids(k));
+    const SPoint3 site =
+      v->point().get_projection(ball.center(), ball.radius());
+    std::vector<double> cell;
+    std::vector<int> neighbors;
+    siteCell(dtos, v, cell, neighbors);
+    Rcpp::NumericMatrix Cell(3, neighbors.size());
+    std::copy(cell.begin(), cell.end(), Cell.begin());
+    Cells(k) = Rcpp::List::create(
+      Rcpp::Named("site")      = Rcpp::NumericVector::create(
+        site.x(), site.y(), site.z()
+      ),
+      Rcpp::Named("cell")      = Cell,
+      Rcpp::Named("neighbors") = Rcpp::wrap(neighbors)
+    );
+  }
+  return Cells;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// faces of the Delaunay triangulation incident to the given sites, each one
+// given once, in the order of the sites and then counterclockwise around
+// each site
+std::vector<DToS::Face_handle> incidentFaces(
+    const Tessellation& tess, const Rcpp::IntegerVector ids
+) {
+  const DToS& dtos = tess.dtos;
+  std::set<DToS::Face_handle> visited;
+  std::vector<DToS::Face_handle> fhs;
+  for(const int id : ids) {
+    const DToS::Vertex_handle v = siteVertex(tess, id);
+    const DToS::Face_circulator done = dtos.incident_faces(v);
+    DToS::Face_circulator fc = done;
+    do {
+      const DToS::Face_handle fh = fc;
+      if(visited.insert(fh).second) {
+        fhs.push_back(fh);
+      }
+    } while(++fc != done);
+  }
+  return fhs;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// faces of the Delaunay triangulation incident to the given sites, each one
+// given once, by the identifiers of its vertices
+// [[Rcpp::export]]
+Rcpp::IntegerMatrix tessellation_faces(
+    Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids
+) {
+  const Tessellation& tess = *xptr;
+  if(tess.dtos.dimension() < 2) {
+    Rcpp::stop("The triangulation is not two-dimensional.");
+  }
+  std::vector<int> faces;
+  for(const DToS::Face_handle fh : incidentFaces(tess, ids)) {
+    for(int i = 0; i < 3; i++) {
+      faces.push_back(fh->vertex(i)->info());
+    }
+  }
+  const int nfaces = faces.size() / 3;
+  Rcpp::IntegerMatrix Faces(3, nfaces);
+  std::copy(faces.begin(), faces.end(), Faces.begin());
+  return Rcpp::transpose(Faces);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// for each point (column of `pts`), the face of the triangulation containing
+// it and the nearest site; the points are processed along a Hilbert curve if
+// there are many of them, each location starting from the face found for the
+// previous point; the chunks of points are processed with `nthreads`
+// threads, which only read the triangulation
+// [[Rcpp::export]]
+Rcpp::List tessellation_locate(
+    Rcpp::XPtr<Tessellation> xptr, Rcpp::NumericMatrix pts, int nthreads
+) {
+  const Tessellation& tess = *xptr;
+  const DToS& dtos = tess.dtos;
+  if(dtos.dimension() < 2) {
+    Rcpp::stop("The triangulation is not two-dimensional.");
+  }
+  const Traits& ball = dtos.geom_traits();
+  std::vector<PointOnSphere> spoints;
+  std::vector<SPoint3> projections;
+  projectPoints(ball, pts, spoints, projections);
+  const int npoints = spoints.size();
+  std::vector<int> order;
+  if(npoints >= 1000) {
+    order = hilbertOrder(projections, ball.center(), ball.radius());
+  } else {
+    order.resize(npoints);
+    for(int i = 0; i < npoints; i++) {
+      order[i] = i;
+    }
+  }
+  std::vector<int> faces(3 * npoints);
+  std::vector<int> nearest(npoints);
+  parallelFor(npoints, nthreads, [&](int begin, int end, int) {
+    DToS::Face_handle hint;
+    for(int k = begin; k < end; k++) {
+      const int i = order[k];
+      DToS::Locate_type lt;
+      int li;
+      hint = dtos.locate(spoints[i], lt, li, hint);
+      for(int j = 0; j < 3; j++) {
+        faces[3*i + j] = hint->vertex(j)->info();
+      }
+      nearest[i] = dtos.nearest_vertex(spoints[i], hint)->info();
+    }
+  });
+  Rcpp::IntegerMatrix Faces(3, npoints);
+  std::copy(faces.begin(), faces.end(), Faces.begin());
+  return Rcpp::List::create(
+    Rcpp::Named("face") = Rcpp::transpose(Faces),
+    Rcpp::Named("site") = Rcpp::wrap(nearest)
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// sites whose cells may have changed and removed sites since the last call
+// [[Rcpp::export]]
+Rcpp::List tessellation_changes(Rcpp::XPtr<Tessellation> xptr) {
+  Tessellation& tess = *xptr;
+  std::vector<int> modified;
+  modified.reserve(tess.modified.size());
+  for(const int id : tess.modified) {
+    tess.isModified[id - 1] = false;
+    if(tess.handles[id - 1] != DToS::Vertex_handle()) {
+      modified.push_back(id);
+    }
+  }
+  std::sort(modified.begin(), modified.end());
+  std::vector<int> removed(tess.removed);
+  std::sort(removed.begin(), removed.end());
+  tess.modified.clear();
+  tess.removed.clear();
+  return Rcpp::List::create(
+    Rcpp::Named("modified") = Rcpp::wrap(modified),
+    Rcpp::Named("removed")  = Rcpp::wrap(removed)
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// sets the subdivision parameters of the meshes to be returned; the cached
+// meshes are dropped if they have been computed with other parameters
+void meshParameters(Tessellation& tess, int level, double tolerance) {
+  const bool changed = tolerance > 0
+    ? tolerance != tess.meshTolerance
+    : tess.meshTolerance > 0 || level != tess.meshLevel;
+  if(changed) {
+    tess.cellMeshes.clear();
+    tess.faceMeshes.clear();
+    tess.siteFaces.clear();
+  }
+  tess.meshLevel = level;
+  tess.meshTolerance = tolerance;
+}
+
+// render-ready form of a list of meshes, written concurrently at their places
+// in a single mesh; the triangles of the k-th mesh get the identifier ids[k]
+Rcpp::List packMeshes(
+    const std::vector<const SMesh*>& smeshes, const std::vector<int>& ids,
+    const double* O, int nthreads
+) {
+  const int nmeshes = smeshes.size();
+  std::vector<size_t> vertexOffsets(nmeshes + 1, 0);
+  std::vector<size_t> triangleOffsets(nmeshes + 1, 0);
+  for(int k = 0; k < nmeshes; k++) {
+    vertexOffsets[k + 1] = vertexOffsets[k] + smeshes[k]->vertices.size() / 3;
+    triangleOffsets[k + 1] =
+      triangleOffsets[k] + smeshes[k]->faces.size() / 3;
+  }
+  const size_t nvertices = vertexOffsets[nmeshes];
+  const size_t ntriangles = triangleOffsets[nmeshes];
+  if(nvertices > size_t(INT_MAX) || 3 * ntriangles > size_t(INT_MAX)) {
+    Rcpp::stop("The mesh is too large; reduce the number of iterations.");
+  }
+  Rcpp::NumericMatrix Vertices(6, nvertices);
+  Rcpp::IntegerMatrix Indices(3, ntriangles);
+  Rcpp::IntegerVector Ids(ntriangles);
+  double* vbuffer = Vertices.begin();
+  int* ibuffer = Indices.begin();
+  int* idbuffer = Ids.begin();
+  parallelFor(nmeshes, nthreads, [&](int begin, int end, int) {
+    for(int k = begin; k < end; k++) {
+      packMesh(
+        *smeshes[k], O, vertexOffsets[k], triangleOffsets[k], vbuffer, ibuffer
+      );
+      std::fill(
+        idbuffer + triangleOffsets[k], idbuffer + triangleOffsets[k + 1],
+        ids[k]
+      );
+    }
+  });
+  return renderMesh(Vertices, Indices, Ids);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// mesh of the Voronoï cells of the given sites, each cell being meshed as the
+// star triangulation from its site subdivided niter-1 times, or adaptively
+// within `tolerance` if it is positive; only the meshes which are not cached
+// are computed, with `nthreads` threads, and they are cached; the field
+// `ids` of the mesh gives the identifier of the site of each triangle
+// [[Rcpp::export]]
+Rcpp::List tessellation_voronoi_mesh(
+    Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids, int niter,
+    double tolerance, int nthreads
+) {
+  Tessellation& tess = *xptr;
+  const DToS& dtos = tess.dtos;
+  if(dtos.dimension() < 2) {
+    Rcpp::stop("The triangulation is not two-dimensional.");
+  }
+  const Traits& ball = dtos.geom_traits();
+  const double radius = ball.radius();
+  const double O[3] = {ball.center().x(), ball.center().y(), ball.center().z()};
+  const int nids = ids.size();
+  std::vector<DToS::Vertex_handle> vhs(nids);
+  for(int k = 0; k < nids; k++) {
+    vhs[k] = siteVertex(tess, ids(k));
+  }
+  const int level = niter - 1;
+  meshParameters(tess, level, tolerance);
+  // the missing cells, given by their vertices followed by their sites; their
+  // meshes are cached once they are all computed
+  std::vector<std::vector<double>> polygons;
+  std::vector<int> missing;
+  std::unordered_set<int> pending;
+  std::vector<int> neighbors;
+  for(int k = 0; k < nids; k++) {
+    if(tess.cellMeshes.count(ids(k)) || !pending.insert(ids(k)).second) {
+      continue;
+    }
+    std::vector<double> polygon;
+    siteCell(dtos, vhs[k], polygon, neighbors);
+    const SPoint3 site =
+      vhs[k]->point().get_projection(ball.center(), radius);
+    polygon.push_back(site.x());
+    polygon.push_back(site.y());
+    polygon.push_back(site.z());
+    polygons.push_back(std::move(polygon));
+    missing.push_back(ids(k));
+  }
+  std::vector<SMesh> computed(missing.size());
+  const int n = 1 << level;
+  std::vector<int> local(tolerance > 0 ? 0 : 3 * n * n);
+  if(tolerance <= 0) {
+    triangleFaces(level, local.data(), 0);
+  }
+  parallelFor(missing.size(), nthreads, [&](int begin, int end, int) {
+    FaceScratch scratch;
+    for(int k = begin; k < end; k++) {
+      const double* points = polygons[k].data();
+      const int ncorners = polygons[k].size() / 3 - 1;
+      if(tolerance > 0) {
+        subdivideStarAdaptive(
+          points, ncorners, tolerance, radius, O, scratch, computed[k]
+        );
+      } else {
+        subdivideStar(
+          points, ncorners, level, radius, O, local.data(), scratch,
+          computed[k]
+        );
+      }
+    }
+  });
+  for(size_t k = 0; k < missing.size(); k++) {
+    tess.cellMeshes.emplace(missing[k], std::move(computed[k]));
+  }
+  std::vector<const SMesh*> smeshes(nids);
+  for(int k = 0; k < nids; k++) {
+    smeshes[k] = &tess.cellMeshes.at(ids(k));
+  }
+  return packMeshes(
+    smeshes, std::vector<int>(ids.begin(), ids.end()), O, nthreads
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// mesh of the solid Delaunay faces incident to the given sites, in the order
+// given by tessellation_faces, each face being subdivided niter-1 times, or
+// adaptively within `tolerance` if it is positive; the levels of the edges
+// of a face only depend on the edges, so the meshes of two adjacent faces
+// match; only the meshes which are not cached are computed, with `nthreads`
+// threads, and they are cached; the field `ids` of the mesh gives the index
+// of the face of each triangle in the output of tessellation_faces
+// [[Rcpp::export]]
+Rcpp::List tessellation_delaunay_mesh(
+    Rcpp::XPtr<Tessellation> xptr, Rcpp::IntegerVector ids, int niter,
+    double tolerance, int nthreads
+) {
+  Tessellation& tess = *xptr;
+  const DToS& dtos = tess.dtos;
+  if(dtos.dimension() < 2) {
+    Rcpp::stop("The triangulation is not two-dimensional.");
+  }
+  const Traits& ball = dtos.geom_traits();
+  const double radius = ball.radius();
+  const double O[3] = {ball.center().x(), ball.center().y(), ball.center().z()};
+  const std::vector<DToS::Face_handle> fhs = incidentFaces(tess, ids);
+  const int level = niter - 1;
+  meshParameters(tess, level, tolerance);
+  trimFaceMeshes(tess);
+  // the vertices of a missing face are sorted by identifier, so that its
+  // edges are oriented as in the adjacent faces
+  std::vector<std::vector<double>> corners;
+  std::vector<std::vector<int>> triangles;
+  std::vector<std::array<int, 3>> keys;
+  std::vector<std::array<int, 3>> missing;
+  std::vector<int> faceIds;
+  for(size_t f = 0; f < fhs.size(); f++) {
+    const DToS::Face_handle fh = fhs[f];
+    if(fh->is_ghost()) {
+      continue;
+    }
+    std::array<int, 3> key;
+    for(int i = 0; i < 3; i++) {
+      key[i] = fh->vertex(i)->info();
+    }
+    std::sort(key.begin(), key.end());
+    keys.push_back(key);
+    faceIds.push_back(f + 1);
+    if(tess.faceMeshes.count(key)) {
+      continue;
+    }
+    std::vector<double> points(9);
+    std::vector<int> triangle(3);
+    for(int i = 0; i < 3; i++) {
+      const DToS::Vertex_handle vh = fh->vertex(i);
+      const int r = std::find(key.begin(), key.end(), vh->info()) - key.begin();
+      const SPoint3 p = vh->point().get_projection(ball.center(), radius);
+      points[3*r]     = p.x();
+      points[3*r + 1] = p.y();
+      points[3*r + 2] = p.z();
+      triangle[i] = r;
+    }
+    corners.push_back(std::move(points));
+    triangles.push_back(std::move(triangle));
+    missing.push_back(key);
+  }
+  // the meshes are cached once they are all computed
+  std::vector<SMesh> computed(missing.size());
+  parallelFor(missing.size(), nthreads, [&](int begin, int end, int) {
+    for(int k = begin; k < end; k++) {
+      computed[k] = tolerance > 0
+        ? subdivideMeshAdaptive(
+            corners[k], triangles[k], tolerance, radius, O, 1
+          )
+        : subdivideMesh(corners[k], triangles[k], level, radius, O, 1);
+    }
+  });
+  for(size_t k = 0; k < missing.size(); k++) {
+    cacheFaceMesh(tess, missing[k], std::move(computed[k]));
+  }
+  std::vector<const SMesh*> smeshes;
+  for(const std::array<int, 3>& key : keys) {
+    smeshes.push_back(&tess.faceMeshes.at(key));
+  }
+  return packMeshes(smeshes, faceIds, O, nthreads);
+}
@@ -0,0 +1,347 @@
+#include "sphereTessellation.h"
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Hilbert key of a point of the cube [0, 2^21)^3 (Skilling's algorithm)
+uint64_t hilbertKey(uint32_t X[3]) {
+  const int nbits = 21;
+  const uint32_t M = 1u << (nbits - 1);
+  // inverse undo excess work
+  for(uint32_t Q = M; Q > 1; Q >>= 1) {
+    const uint32_t P = Q - 1;
+    for(int i = 0; i < 3; i++) {
+      if(X[i] & Q) {
+        X[0] ^= P;
+      } else {
+        const uint32_t t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+  // Gray encode
+  X[1] ^= X[0];
+  X[2] ^= X[1];
+  uint32_t t = 0;
+  for(uint32_t Q = M; Q > 1; Q >>= 1) {
+    if(X[2] & Q) {
+      t ^= Q - 1;
+    }
+  }
+  X[0] ^= t;
+  X[1] ^= t;
+  X[2] ^= t;
+  // interleave the bits
+  uint64_t key = 0;
+  for(int j = nbits - 1; j >= 0; j--) {
+    for(int i = 0; i < 3; i++) {
+      key = (key << 1) | ((X[i] >> j) & 1u);
+    }
+  }
+  return key;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// coordinates in the cube [0, 2^21)^3 of a point of the sphere with center O
+// and radius `radius`
+void hilbertCoordinates(
+    const SPoint3& p, const SPoint3& O, double radius, uint32_t X[3]
+) {
+  const double scale = 0.5 * double((1u << 21) - 1) / radius;
+  X[0] = uint32_t((p.x() - O.x() + radius) * scale);
+  X[1] = uint32_t((p.y() - O.y() + radius) * scale);
+  X[2] = uint32_t((p.z() - O.z() + radius) * scale);
+}
+
+// Hilbert keys of the points, paired with the indices of the points and
+// sorted; the points are assumed to lie on the sphere with center O and
+// radius `radius`; with several threads, the keys are sorted by chunks which
+// are then merged pairwise
+std::vector<std::pair<uint64_t, int>> hilbertKeys(
+    const std::vector<SPoint3>& points, const SPoint3& O, double radius,
+    int nthreads
+) {
+  const int npoints = points.size();
+  std::vector<std::pair<uint64_t, int>> keys(npoints);
+  parallelFor(npoints, nthreads, [&](int begin, int end, int) {
+    for(int i = begin; i < end; i++) {
+      uint32_t X[3];
+      hilbertCoordinates(points[i], O, radius, X);
+      keys[i] = std::make_pair(hilbertKey(X), i);
+    }
+  });
+  const int nchunks = std::max(1, std::min(nthreads, npoints / 10000));
+  std::vector<int> bounds(nchunks + 1);
+  for(int c = 0; c <= nchunks; c++) {
+    bounds[c] = int(int64_t(npoints) * c / nchunks);
+  }
+  parallelFor(nchunks, nthreads, [&](int begin, int end, int) {
+    for(int c = begin; c < end; c++) {
+      std::sort(keys.begin() + bounds[c], keys.begin() + bounds[c + 1]);
+    }
+  }, 1);
+  for(int width = 1; width < nchunks; width *= 2) {
+    const int nmerges = (nchunks + 2 * width - 1) / (2 * width);
+    parallelFor(nmerges, nthreads, [&](int begin, int end, int) {
+      for(int m = begin; m < end; m++) {
+        const int first = 2 * m * width;
+        const int middle = std::min(first + width, nchunks);
+        const int last = std::min(first + 2 * width, nchunks);
+        std::inplace_merge(
+          keys.begin() + bounds[first], keys.begin() + bounds[middle],
+          keys.begin() + bounds[last]
+        );
+      }
+    }, 1);
+  }
+  return keys;
+}
+
+// order of the points along a Hilbert curve
+std::vector<int> hilbertOrder(
+    const std::vector<SPoint3>& points, const SPoint3& O, double radius
+) {
+  const std::vector<std::pair<uint64_t, int>> keys =
+    hilbertKeys(points, O, radius, 1);
+  const size_t npoints = keys.size();
+  std::vector<int> order(npoints);
+  for(size_t i = 0; i < npoints; i++) {
+    order[i] = keys[i].second;
+  }
+  return order;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// projects the points (columns of `pts`) on the sphere; `spoints` receives the
+// points in the representation of the traits and `projections` their
+// Cartesian coordinates
+void projectPoints(
+    const Traits& ball, const Rcpp::NumericMatrix pts,
+    std::vector<PointOnSphere>& spoints, std::vector<SPoint3>& projections
+) {
+  const SPoint3 O = ball.center();
+  const double radius = ball.radius();
+  Traits::Construct_point_on_sphere_2 projection =
+    ball.construct_point_on_sphere_2_object();
+  const int npoints = pts.ncol();
+  spoints.clear();
+  spoints.reserve(npoints);
+  projections.clear();
+  projections.reserve(npoints);
+  for(int i = 0; i < npoints; i++) {
+    const SPoint3 pt(pts(0, i), pts(1, i), pts(2, i));
+    const PointOnSphere pos = projection(pt);
+    spoints.push_back(pos);
+    projections.push_back(pos.get_projection(O, radius));
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// largest coordinate of a cell of the grid used by mergePoints
+const int64_t maxMergeCell = (int64_t(1) << 21) - 1;
+
+// key of a cell of this grid, whose coordinates are in [0, maxMergeCell]
+inline uint64_t mergeCellKey(const int64_t X[3]) {
+  return uint64_t(X[0]) | uint64_t(X[1]) << 21 | uint64_t(X[2]) << 42;
+}
+
+// Merges the points whose projections are at a distance at most `epsilon`,
+// or equal up to the rounding errors, each point being merged into the first
+// kept point close enough. The kept points are moved to the front of
+// `spoints` and `projections`, which are truncated, and the returned vector
+// gives for each point the zero-based index of its kept point. The kept
+// points are stored in a hash table of the cells of a grid of width at least
+// `epsilon`, and each point is compared to the kept points of the 27 cells
+// around it only, so that this takes a linear time. The hash table and the
+// lists are kept in `scratch`, which keeps their storage from one call to the
+// next, and the indices of the kept points are written in `mapping`.
+void mergePoints(
+    std::vector<PointOnSphere>& spoints, std::vector<SPoint3>& projections,
+    const SPoint3& O, double radius, double epsilon, MergeScratch& scratch,
+    std::vector<int>& mapping
+) {
+  const int npoints = projections.size();
+  const double threshold = std::max(epsilon, 16 * DBL_EPSILON * radius);
+  // with this width, the cells have 21-bit coordinates
+  const double width = std::max(epsilon, radius / (1 << 19));
+  const double origin[3] = {O.x() - radius, O.y() - radius, O.z() - radius};
+  // kept points of each cell, as linked lists
+  std::unordered_map<uint64_t, int>& heads = scratch.heads;
+  heads.clear();
+  heads.reserve(npoints);
+  std::vector<int>& next = scratch.next;
+  next.clear();
+  next.reserve(npoints);
+  mapping.resize(npoints);
+  int nkept = 0;
+  for(int i = 0; i < npoints; i++) {
+    const SPoint3 p = projections[i];
+    const double xyz[3] = {p.x(), p.y(), p.z()};
+    // the coordinates are clamped since a projection may be rounded just
+    // outside the cube around the sphere
+    int64_t cell[3];
+    for(int j = 0; j < 3; j++) {
+      cell[j] = std::min(
+        std::max(int64_t(floor((xyz[j] - origin[j]) / width)), int64_t(0)),
+        maxMergeCell
+      );
+    }
+    int closest = -1;
+    for(int c = 0; c < 27; c++) {
+      const int64_t X[3] = {
+        cell[0] + c % 3 - 1, cell[1] + c / 3 % 3 - 1, cell[2] + c / 9 - 1
+      };
+      if(std::min({X[0], X[1], X[2]}) < 0 ||
+         std::max({X[0], X[1], X[2]}) > maxMergeCell) {
+        continue;
+      }
+      const auto head = heads.find(mergeCellKey(X));
+      if(head == heads.end()) {
+        continue;
+      }
+      for(int k = head->second; k != -1; k = next[k]) {
+        const SPoint3& q = projections[k];
+        const double dx = q.x() - xyz[0];
+        const double dy = q.y() - xyz[1];
+        const double dz = q.z() - xyz[2];
+        if(dx*dx + dy*dy + dz*dz <= threshold * threshold &&
+           (closest == -1 || k < closest)) {
+          closest = k;
+        }
+      }
+    }
+    if(closest != -1) {
+      mapping[i] = closest;
+      continue;
+    }
+    // kept point
+    spoints[nkept] = spoints[i];
+    projections[nkept] = p;
+    mapping[i] = nkept;
+    const auto inserted = heads.emplace(mergeCellKey(cell), nkept);
+    next.push_back(inserted.second ? -1 : inserted.first->second);
+    inserted.first->second = nkept;
+    nkept++;
+  }
+  spoints.resize(nkept);
+  projections.resize(nkept);
+}
+
+std::vector<int> mergePoints(
+    std::vector<PointOnSphere>& spoints, std::vector<SPoint3>& projections,
+    const SPoint3& O, double radius, double epsilon
+) {
+  MergeScratch scratch;
+  std::vector<int> mapping;
+  mergePoints(spoints, projections, O, radius, epsilon, scratch, mapping);
+  return mapping;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// inserts the points in the triangulation and returns their vertex handles;
+// the info of the vertex of the i-th point is `firstinfo + i`; a point which
+// is already a vertex of the triangulation gets a null handle; if
+// `spatialsort` is true, the points are inserted along a Hilbert curve, each
+// insertion starting its location walk from the face of the previously
+// inserted vertex
+std::vector<DToS::Vertex_handle> insertPoints(
+    DToS& dtos, const std::vector<PointOnSphere>& spoints,
+    const std::vector<SPoint3>& projections, bool spatialsort, int firstinfo
+) {
+  const Traits& ball = dtos.geom_traits();
+  const int npoints = spoints.size();
+  std::vector<DToS::Vertex_handle> vhs(npoints);
+  std::vector<int> order;
+  if(spatialsort) {
+    order = hilbertOrder(projections, ball.center(), ball.radius());
+  } else {
+    order.resize(npoints);
+    for(int i = 0; i < npoints; i++) {
+      order[i] = i;
+    }
+  }
+  DToS::Face_handle hint;
+  for(const int i : order) {
+    const size_t nvertices = dtos.number_of_vertices();
+    const DToS::Vertex_handle vh = dtos.insert(spoints[i], hint);
+    if(vh == DToS::Vertex_handle() || dtos.number_of_vertices() == nvertices) {
+      continue;
+    }
+    vh->info() = firstinfo + i;
+    vhs[i] = vh;
+    if(spatialsort && dtos.dimension() == 2) {
+      hint = vh->face();
+    }
+  }
+  return vhs;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// The points which have not been inserted by insertPoints (with `firstinfo`
+// equal to 1), because CGAL found them equal to some vertices, are merged
+// into the nearest vertices: the infos of the vertices are renumbered
+// consecutively, `projections` is truncated accordingly and `mapping`,
+// given by mergePoints, is updated.
+void mergeVertices(
+    const DToS& dtos, const std::vector<DToS::Vertex_handle>& vhs,
+    const std::vector<PointOnSphere>& spoints,
+    std::vector<SPoint3>& projections, std::vector<int>& mapping
+) {
+  const int npoints = vhs.size();
+  if(dtos.number_of_vertices() == size_t(npoints)) {
+    return;
+  }
+  std::vector<int> indices(npoints);
+  int nvertices = 0;
+  for(int k = 0; k < npoints; k++) {
+    if(vhs[k] != DToS::Vertex_handle()) {
+      projections[nvertices] = projections[k];
+      vhs[k]->info() = nvertices + 1;
+      indices[k] = nvertices++;
+    }
+  }
+  for(int k = 0; k < npoints; k++) {
+    if(vhs[k] == DToS::Vertex_handle()) {
+      indices[k] = dtos.nearest_vertex(spoints[k])->info() - 1;
+    }
+  }
+  projections.resize(nvertices);
+  for(int& index : mapping) {
+    index = indices[index];
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// sets the info of each face (solid or ghost) to its zero-based index in the
+// iteration order of the faces and returns the face handles in this order
+std::vector<DToS::Face_handle> indexFaces(DToS& dtos) {
+  std::vector<DToS::Face_handle> fhs;
+  fhs.reserve(dtos.number_of_faces());
+  int index = 0;
+  for(auto f = dtos.all_faces_begin(); f != dtos.all_faces_end(); f++) {
+    f->info() = index++;
+    fhs.push_back(f);
+  }
+  return fhs;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// vertex handles ordered by their info, that is as the input points
+std::vector<DToS::Vertex_handle> sortedVertices(const DToS& dtos) {
+  const DToS::Vertex_handles vrange = dtos.vertex_handles();
+  std::vector<DToS::Vertex_handle> vhs(vrange.begin(), vrange.end());
+  std::sort(
+    vhs.begin(), vhs.end(),
+    [](const DToS::Vertex_handle& v1, const DToS::Vertex_handle& v2) {
+      return v1->info() < v2->info();
+    }
+  );
+  return vhs;
+}
@@ -6,3 +6,279 @@ void Message(const std::string& msg) {
   SEXP rmsg = Rcpp::wrap(msg);
   Rcpp::message(rmsg);
 }
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// R list representing a mesh in a render-ready form: `vertices` is a 6 x n
+// matrix whose columns are the interleaved coordinates and normals of the
+// vertices, `indices` is the 3 x m matrix of the one-based indices of the
+// triangles and `ids` gives for each triangle the one-based index of the
+// element (face or cell) it comes from
+Rcpp::List renderMesh(
+    const Rcpp::NumericMatrix Vertices, const Rcpp::IntegerMatrix Indices,
+    const Rcpp::IntegerVector Ids
+) {
+  return Rcpp::List::create(
+    Rcpp::Named("vertices") = Vertices,
+    Rcpp::Named("indices")  = Indices,
+    Rcpp::Named("ids")      = Ids
+  );
+}
+
+// render-ready form of a mesh whose offsets give the triangles of each face
+Rcpp::List SMeshToList(const SMesh& smesh, const double* O) {
+  const int nvertices = smesh.vertices.size() / 3;
+  const int ntriangles = smesh.faces.size() / 3;
+  const int nfaces = smesh.offsets.size() - 1;
+  Rcpp::NumericMatrix Vertices(6, nvertices);
+  Rcpp::IntegerMatrix Indices(3, ntriangles);
+  Rcpp::IntegerVector Ids(ntriangles);
+  packMesh(smesh, O, 0, 0, Vertices.begin(), Indices.begin());
+  for(int f = 0; f < nfaces; f++) {
+    std::fill(
+      Ids.begin() + smesh.offsets[f], Ids.begin() + smesh.offsets[f + 1], f + 1
+    );
+  }
+  return renderMesh(Vertices, Indices, Ids);
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// The vertex indices of the triangles of a compact mesh are stored as the
+// differences between consecutive indices (the first one with zero), in
+// zigzag LEB128 varints: the sign goes to the lowest bit, and the bits are
+// written seven by seven, from the lowest ones, the highest bit of a byte
+// being set if another byte follows. The neighbouring points of a mesh are
+// numbered closely, so most indices take one or two bytes instead of four.
+inline uint64_t zigzag(int64_t d) {
+  return d < 0 ? (uint64_t(-d) << 1) - 1 : uint64_t(d) << 1;
+}
+
+inline size_t varintSize(uint64_t z) {
+  size_t size = 1;
+  for(; z >= 0x80; z >>= 7) {
+    size++;
+  }
+  return size;
+}
+
+// encodes the n indices indices[k] + shift; the blocks of indices are
+// measured and then written with `nthreads` threads
+Rcpp::RawVector encodeIndices(
+    const int* indices, size_t n, int shift, int nthreads
+) {
+  const size_t blocksize = 1 << 16;
+  const int nblocks = int((n + blocksize - 1) / blocksize);
+  std::vector<size_t> offsets(nblocks + 1, 0);
+  parallelFor(nblocks, nthreads, [&](int begin, int end, int) {
+    for(int b = begin; b < end; b++) {
+      const size_t first = b * blocksize, last = std::min(n, first + blocksize);
+      int64_t previous = first == 0 ? 0 : int64_t(indices[first - 1]) + shift;
+      size_t size = 0;
+      for(size_t k = first; k < last; k++) {
+        const int64_t index = int64_t(indices[k]) + shift;
+        size += varintSize(zigzag(index - previous));
+        previous = index;
+      }
+      offsets[b + 1] = size;
+    }
+  });
+  for(int b = 0; b < nblocks; b++) {
+    offsets[b + 1] += offsets[b];
+  }
+  Rcpp::RawVector Bytes(offsets[nblocks]);
+  uint8_t* bytes = Bytes.begin();
+  parallelFor(nblocks, nthreads, [&](int begin, int end, int) {
+    for(int b = begin; b < end; b++) {
+      const size_t first = b * blocksize, last = std::min(n, first + blocksize);
+      int64_t previous = first == 0 ? 0 : int64_t(indices[first - 1]) + shift;
+      uint8_t* out = bytes + offsets[b];
+      for(size_t k = first; k < last; k++) {
+        const int64_t index = int64_t(indices[k]) + shift;
+        uint64_t z = zigzag(index - previous);
+        previous = index;
+        for(; z >= 0x80; z >>= 7) {
+          *out++ = uint8_t(z | 0x80);
+        }
+        *out++ = uint8_t(z);
+      }
+    }
+  });
+  return Bytes;
+}
+
+// 3 x m matrix of the one-based vertex indices of the triangles of a compact
+// mesh, decoded from its raw vector `indices`
+// [[Rcpp::export]]
+Rcpp::IntegerMatrix mesh_indices_cpp(Rcpp::RawVector Bytes) {
+  const uint8_t* bytes = Bytes.begin();
+  const size_t nbytes = Bytes.size();
+  size_t n = 0;
+  for(size_t i = 0; i < nbytes; i++) {
+    n += bytes[i] < 0x80;
+  }
+  if(n % 3 != 0 || (nbytes > 0 && bytes[nbytes - 1] >= 0x80)) {
+    Rcpp::stop("Invalid indices of a compact mesh.");
+  }
+  Rcpp::IntegerMatrix Indices(3, n / 3);
+  int64_t index = 0;
+  size_t i = 0;
+  for(size_t k = 0; k < n; k++) {
+    uint64_t z = 0;
+    int shift = 0;
+    for(;; shift += 7) {
+      const uint8_t byte = bytes[i++];
+      if(shift > 63) {
+        Rcpp::stop("Invalid indices of a compact mesh.");
+      }
+      z |= uint64_t(byte & 0x7F) << shift;
+      if(byte < 0x80) {
+        break;
+      }
+    }
+    index += z & 1 ? -int64_t(z >> 1) - 1 : int64_t(z >> 1);
+    if(index < 1 || index > INT_MAX) {
+      Rcpp::stop("Invalid indices of a compact mesh.");
+    }
+    Indices[k] = int(index);
+  }
+  return Indices;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// compact R list representing a mesh: `positions` is a raw vector holding the
+// coordinates of the vertices as single-precision numbers, without their
+// normals, `indices` is a raw vector holding the vertex indices of the
+// triangles encoded by encodeIndices, and the triangles coming from the i-th
+// element are the offsets[i]+1, ..., offsets[i+1]-th ones
+Rcpp::List compactMesh(
+    const Rcpp::RawVector Positions, const Rcpp::RawVector Indices,
+    const Rcpp::IntegerVector Offsets
+) {
+  return Rcpp::List::create(
+    Rcpp::Named("positions") = Positions,
+    Rcpp::Named("indices")   = Indices,
+    Rcpp::Named("offsets")   = Offsets
+  );
+}
+
+// compact form of a mesh whose offsets give the triangles of each face
+Rcpp::List SMeshToCompactList(const SMesh& smesh, int nthreads) {
+  const size_t nvertices = smesh.vertices.size() / 3;
+  Rcpp::RawVector Positions(3 * sizeof(float) * nvertices);
+  std::copy(
+    smesh.vertices.begin(), smesh.vertices.end(),
+    reinterpret_cast<float*>(Positions.begin())
+  );
+  return compactMesh(
+    Positions,
+    encodeIndices(smesh.faces.data(), smesh.faces.size(), 1, nthreads),
+    Rcpp::IntegerVector(smesh.offsets.begin(), smesh.offsets.end())
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+Profile::Profile(bool enabled) : enabled(enabled) {
+  if(enabled) {
+    last = std::chrono::steady_clock::now();
+  }
+}
+
+void Profile::stage(const std::string& name) {
+  if(!enabled) {
+    return;
+  }
+  const std::chrono::steady_clock::time_point now =
+    std::chrono::steady_clock::now();
+  stages.push_back(name);
+  seconds.push_back(std::chrono::duration<double>(now - last).count());
+  last = now;
+}
+
+void Profile::count(const std::string& name, double value) {
+  if(!enabled) {
+    return;
+  }
+  for(size_t i = 0; i < counters.size(); i++) {
+    if(counters[i] == name) {
+      counts[i] += value;
+      return;
+    }
+  }
+  counters.push_back(name);
+  counts.push_back(value);
+}
+
+// number and bytes of the R vectors and lists reachable from x through the
+// elements of the lists, the ones already in `seen` excepted
+void countObjects(
+    SEXP x, std::unordered_set<SEXP>& seen, double& nobjects, double& bytes
+) {
+  if(x == R_NilValue || !seen.insert(x).second) {
+    return;
+  }
+  size_t size;
+  switch(TYPEOF(x)) {
+    case REALSXP:
+      size = sizeof(double);
+      break;
+    case INTSXP:
+    case LGLSXP:
+      size = sizeof(int);
+      break;
+    case RAWSXP:
+      size = 1;
+      break;
+    case STRSXP:
+    case VECSXP:
+      size = sizeof(SEXP);
+      break;
+    default:
+      return;
+  }
+  nobjects++;
+  bytes += double(Rf_xlength(x)) * size;
+  if(TYPEOF(x) == VECSXP) {
+    for(R_xlen_t i = 0; i < Rf_xlength(x); i++) {
+      countObjects(VECTOR_ELT(x, i), seen, nobjects, bytes);
+    }
+  }
+}
+
+void Profile::objects(SEXP x) {
+  if(!enabled) {
+    return;
+  }
+  double nobjects = 0, bytes = 0;
+  countObjects(x, seen, nobjects, bytes);
+  count("RObjects", nobjects);
+  count("RBytes", bytes);
+}
+
+// R list with the data frame of the stages and the named vector of the counts
+Rcpp::List Profile::toList() const {
+  Rcpp::NumericVector Counts(counts.begin(), counts.end());
+  Counts.names() = Rcpp::wrap(counters);
+  return Rcpp::List::create(
+    Rcpp::Named("stages") = Rcpp::DataFrame::create(
+      Rcpp::Named("stage")            = Rcpp::wrap(stages),
+      Rcpp::Named("seconds")          = Rcpp::wrap(seconds),
+      Rcpp::Named("stringsAsFactors") = false
+    ),
+    Rcpp::Named("counts") = Counts
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// one-based version of the mapping of the input points to the kept vertices
+// given by mergePoints
+Rcpp::IntegerVector rowMapping(const std::vector<int>& mapping) {
+  Rcpp::IntegerVector Mapping(mapping.size());
+  for(size_t i = 0; i < mapping.size(); i++) {
+    Mapping(i) = mapping[i] + 1;
+  }
+  return Mapping;
+}
@@ -2,45 +2,220 @@
 
 // -------------------------------------------------------------------------- //
 // -------------------------------------------------------------------------- //
-Rcpp::List joinMeshes(Rcpp::List mesh1, Rcpp::List mesh2) {
-  Rcpp::NumericMatrix Vertices1 = mesh1["vertices"];
-  Rcpp::NumericMatrix Vertices2 = mesh2["vertices"];
-  Rcpp::NumericMatrix Normals1  = mesh1["normals"];
-  Rcpp::NumericMatrix Normals2  = mesh2["normals"];
-  Rcpp::IntegerMatrix Faces1    = mesh1["faces"];
-  Rcpp::IntegerMatrix Faces2    = mesh2["faces"];
-  //
-  const int nvertices1 = Vertices1.ncol();
-  return Rcpp::List::create(
-    Rcpp::Named("vertices") = Rcpp::cbind(Vertices1, Vertices2),
-    Rcpp::Named("faces")    = Rcpp::cbind(Faces1, Faces2 + nvertices1),
-    Rcpp::Named("normals")  = Rcpp::cbind(Normals1, Normals2)
+// Voronoï vertices, as consecutive (x, y, z) triplets: the f-th one is the
+// dual of the face of the triangulation whose info is f; each one is computed
+// only once
+std::vector<double> voronoiVertices(
+    const DToS& dtos, const std::vector<DToS::Face_handle>& fhs, int nthreads
+) {
+  const int nfaces = fhs.size();
+  std::vector<double> vvertices(3 * nfaces);
+  parallelFor(nfaces, nthreads, [&](int begin, int end, int) {
+    for(int f = begin; f < end; f++) {
+      const SPoint3 p = dtos.dual_on_sphere(fhs[f]);
+      vvertices[3*f]     = p.x();
+      vvertices[3*f + 1] = p.y();
+      vvertices[3*f + 2] = p.z();
+    }
+  });
+  return vvertices;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// offsets of the cells of the Voronoï tessellation: offsets[k+1]-offsets[k]
+// is the number of faces around the vertex vhs[k] of the triangulation
+std::vector<size_t> voronoiOffsets(
+    const DToS& dtos, const std::vector<DToS::Vertex_handle>& vhs,
+    int nthreads
+) {
+  const int ncells = vhs.size();
+  std::vector<size_t> offsets(ncells + 1, 0);
+  parallelFor(ncells, nthreads, [&](int begin, int end, int) {
+    for(int k = begin; k < end; k++) {
+      const DToS::Face_circulator done = dtos.incident_faces(vhs[k]);
+      DToS::Face_circulator fc = done;
+      int degree = 0;
+      do {
+        degree++;
+      } while(++fc != done);
+      offsets[k + 1] = degree;
+    }
+  });
+  for(int k = 0; k < ncells; k++) {
+    offsets[k + 1] += offsets[k];
+  }
+  return offsets;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// corners of the cells from the `begin`-th one to the `end-1`-th one, given by
+// the faces around each vertex of the triangulation, whose infos must be set
+// by indexFaces; they are written in `cells` and `neighbors` from the
+// position offsets[k]-offsets[begin] for the k-th cell. The face following f
+// around v is f->neighbor(ccw(i)), i = f->index(v), hence these two faces
+// share the edge joining v to f->vertex(cw(i)).
+void voronoiCorners(
+    const DToS& dtos, const std::vector<DToS::Vertex_handle>& vhs,
+    const std::vector<size_t>& offsets, int begin, int end, int nthreads,
+    int* cells, int* neighbors
+) {
+  const size_t base = offsets[begin];
+  parallelFor(end - begin, nthreads, [&](int first, int last, int) {
+    for(int k = begin + first; k < begin + last; k++) {
+      const DToS::Vertex_handle v = vhs[k];
+      const DToS::Face_circulator done = dtos.incident_faces(v);
+      DToS::Face_circulator fc = done;
+      size_t l = offsets[k] - base;
+      do {
+        cells[l] = fc->info();
+        neighbors[l] = fc->vertex(dtos.cw(fc->index(v)))->info();
+        l++;
+      } while(++fc != done);
+    }
+  });
+}
+
+// cells of the Voronoï tessellation, ordered as the vertex handles `vhs`
+VoronoiTopology voronoiTopology(
+    const DToS& dtos, const std::vector<DToS::Vertex_handle>& vhs,
+    int nthreads
+) {
+  const int ncells = vhs.size();
+  VoronoiTopology topology;
+  const std::vector<size_t> offsets = voronoiOffsets(dtos, vhs, nthreads);
+  if(offsets[ncells] > size_t(INT_MAX)) {
+    Rcpp::stop("The tessellation is too large.");
+  }
+  topology.offsets.assign(offsets.begin(), offsets.end());
+  topology.cells.resize(offsets[ncells]);
+  topology.neighbors.resize(offsets[ncells]);
+  voronoiCorners(
+    dtos, vhs, offsets, 0, ncells, nthreads, topology.cells.data(),
+    topology.neighbors.data()
   );
+  return topology;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Voronoï cell of the vertex v: its site, its vertices (taken from the table
+// of the Voronoï vertices, given by their indices `corners`) followed by its
+// site, and the mesh of the star triangulation of the cell from its site;
+// `local` holds the triangles of the grid of a subdivided triangle; if
+// `edgeLevels` is not null, the star is subdivided adaptively with the levels
+// of its edges and faces given by starLayout, and `level` and `local` are
+// ignored
+void voronoiCell(
+    const DToS& dtos, const DToS::Vertex_handle v, const int* corners,
+    int cellsize, const std::vector<double>& vvertices, int level,
+    const int* edgeLevels, const int* faceLevels, const double* O,
+    const int* local, FaceScratch& scratch, VoronoiCell& vcell
+) {
+  const Traits& ball = dtos.geom_traits();
+  const double radius = ball.radius();
+  const SPoint3 coords = v->point().get_projection(ball.center(), radius);
+  vcell.site[0] = coords.x();
+  vcell.site[1] = coords.y();
+  vcell.site[2] = coords.z();
+  // vertices of the cell, then its site
+  std::vector<double>& cell = vcell.vertices;
+  cell.resize(3 * (cellsize + 1));
+  for(int i = 0; i < cellsize; i++) {
+    const double* p = &vvertices[3 * corners[i]];
+    std::copy(p, p + 3, &cell[3*i]);
+  }
+  std::copy(vcell.site, vcell.site + 3, &cell[3 * cellsize]);
+  // mesh of the star triangulation, in a buffer sized from the cell size
+  if(edgeLevels) {
+    subdivideStarLevels(
+      cell.data(), cellsize, edgeLevels, faceLevels, radius, O, scratch,
+      vcell.mesh
+    );
+  } else {
+    subdivideStar(
+      cell.data(), cellsize, level, radius, O, local, scratch, vcell.mesh
+    );
+  }
+}
+
+// geodesic distances of the vertices of the mesh of a Voronoï cell to its
+// site, relative to the largest one, written at `gradient`; this is the scalar
+// mapped to the palette by the "gradient" coloring of plotVoronoiOnSphere
+template <typename T>
+void cellGradient(const VoronoiCell& vcell, const double* O, T* gradient) {
+  const std::vector<double>& vertices = vcell.mesh.vertices;
+  const int nvertices = vertices.size() / 3;
+  const double s[3] = {
+    vcell.site[0] - O[0], vcell.site[1] - O[1], vcell.site[2] - O[2]
+  };
+  double maxAngle = 0;
+  for(int i = 0; i < nvertices; i++) {
+    const double u[3] = {
+      vertices[3*i] - O[0], vertices[3*i + 1] - O[1], vertices[3*i + 2] - O[2]
+    };
+    const double cx = u[1]*s[2] - u[2]*s[1];
+    const double cy = u[2]*s[0] - u[0]*s[2];
+    const double cz = u[0]*s[1] - u[1]*s[0];
+    const double angle = atan2(
+      sqrt(cx*cx + cy*cy + cz*cz), u[0]*s[0] + u[1]*s[1] + u[2]*s[2]
+    );
+    gradient[i] = T(angle);
+    maxAngle = std::max(maxAngle, angle);
+  }
+  for(int i = 0; i < nvertices; i++) {
+    gradient[i] = maxAngle > 0 ? T(gradient[i] / maxAngle) : T(0);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// matrix of the Voronoï vertices, one per row
+Rcpp::NumericMatrix voronoiVerticesMatrix(
+    const std::vector<double>& vvertices
+) {
+  const int nvvertices = vvertices.size() / 3;
+  Rcpp::NumericMatrix Vertices(nvvertices, 3);
+  for(int f = 0; f < nvvertices; f++) {
+    for(int j = 0; j < 3; j++) {
+      Vertices(f, j) = vvertices[3*f + j];
+    }
+  }
+  return Vertices;
 }
 
 // -------------------------------------------------------------------------- //
 // -------------------------------------------------------------------------- //
 // [[Rcpp::export]]
 Rcpp::List voronoi_cpp(
-    Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter
+    Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter,
+    bool meshes, bool spatialsort, int nthreads, bool profiling = false,
+    double tolerance = 0, bool compact = false, bool metrics = false,
+    double epsilon = 0, bool gradient = false
 ) {
-  const int npoints = pts.ncol();
-  std::vector<SPoint3> points;
-  points.reserve(npoints);
-  for(int i = 0; i < npoints; i++) {
-    Rcpp::NumericVector pt_i = pts(Rcpp::_, i);
-    points.emplace_back(pt_i(0), pt_i(1), pt_i(2));
-  }
+  Profile profile(profiling);
   // ball
   Traits ball(SPoint3(O(0), O(1), O(2)), radius);
-  // projection on this ball
-  Traits::Construct_point_on_sphere_2 projection =
-    ball.construct_point_on_sphere_2_object();
   // make Delaunay triangulation
-  DToS2 dtos(ball);
-  for(const auto& pt : points) {
-    dtos.insert(projection(pt));
-  }
+  DToS dtos(ball);
+  std::vector<PointOnSphere> spoints;
+  std::vector<SPoint3> projections;
+  projectPoints(ball, pts, spoints, projections);
+  // duplicated and close points, merged into the kept vertices
+  std::vector<int> mapping =
+    mergePoints(spoints, projections, ball.center(), radius, epsilon);
+  profile.stage("projection");
+  profile.count("mergedPoints", pts.ncol() - projections.size());
+  const std::vector<DToS::Vertex_handle> handles =
+    insertPoints(dtos, spoints, projections, spatialsort, 1);
+  mergeVertices(dtos, handles, spoints, projections, mapping);
+  profile.stage("insertion");
+  profile.count(
+    "bytes",
+    bufferBytes(spoints) + bufferBytes(projections) + bufferBytes(mapping) +
+      bufferBytes(handles)
+  );
   // check dimension
   int dim = dtos.dimension();
   if(dim == -2) {
@@ -60,45 +235,272 @@ Rcpp::List voronoi_cpp(
   if(nghostFaces != 0) {
     Rcpp::warning("There are some ghost faces in the Delaunay triangulation.");
   }
-  // make Voronoï cells
-  const int ncells = dtos.number_of_vertices();
-  Rcpp::List Voronoi(ncells);
-  const DToS2::Vertex_handles vhs = dtos.vertex_handles();
-  int k = 0;
-  for(auto v = vhs.begin(); v != vhs.end(); v++) {
-    const SPoint3 coords =
-      (*v)->point().get_projection(ball.center(), ball.radius());
-    const Rcpp::NumericVector site = {coords.x(), coords.y(), coords.z()};
-    const DToS2::Edge_circulator ec = dtos.incident_edges(*v);
-    const CC_Edges cc_edges(ec);
-    const int cellsize = std::distance(cc_edges.begin(), cc_edges.end());
-    Rcpp::NumericMatrix Cell(3, cellsize);
-    {
-      int i = 0;
-      for(auto e = cc_edges.begin(); e != cc_edges.end(); e++) {
-        const Arc arc = dtos.dual_on_sphere(*e);
-        const CGAL::Circular_arc_point_3 startpoint = arc.source();
-        const Rcpp::NumericVector vv =
-          {startpoint.x(), startpoint.y(), startpoint.z()};
-        Cell(Rcpp::_, i++) = vv;
+  profile.count("vertices", dtos.number_of_vertices());
+  profile.count("solidFaces", dtos.number_of_solid_faces());
+  profile.count("ghostFaces", nghostFaces);
+  // Voronoï vertices, shared by the cells
+  const std::vector<DToS::Face_handle> fhs = indexFaces(dtos);
+  const std::vector<double> vvertices = voronoiVertices(dtos, fhs, nthreads);
+  profile.stage("duals");
+  profile.count("voronoiVertices", fhs.size());
+  profile.count("bytes", bufferBytes(fhs) + bufferBytes(vvertices));
+  // Voronoï cells, ordered as the input points
+  const std::vector<DToS::Vertex_handle> vhs = sortedVertices(dtos);
+  const int ncells = vhs.size();
+  const VoronoiTopology topology = voronoiTopology(dtos, vhs, nthreads);
+  const std::vector<int>& offsets = topology.offsets;
+  profile.stage("topology");
+  profile.count(
+    "bytes",
+    bufferBytes(vhs) + bufferBytes(topology.offsets) +
+      bufferBytes(topology.cells) + bufferBytes(topology.neighbors)
+  );
+  // areas, perimeters and centroids of the cells
+  Rcpp::List Metrics;
+  if(metrics) {
+    std::vector<double> sites(3 * ncells);
+    for(int k = 0; k < ncells; k++) {
+      const SPoint3 site =
+        vhs[k]->point().get_projection(ball.center(), ball.radius());
+      sites[3*k]     = site.x();
+      sites[3*k + 1] = site.y();
+      sites[3*k + 2] = site.z();
+    }
+    const double center[3] = {O(0), O(1), O(2)};
+    Metrics =
+      voronoiMetrics(vvertices, topology, sites, center, radius, nthreads);
+    profile.stage("metrics");
+    profile.count("bytes", bufferBytes(sites));
+  }
+  if(!meshes) {
+    Rcpp::NumericMatrix Sites(ncells, 3);
+    for(int k = 0; k < ncells; k++) {
+      const SPoint3 site =
+        vhs[k]->point().get_projection(ball.center(), ball.radius());
+      Sites(k, 0) = site.x();
+      Sites(k, 1) = site.y();
+      Sites(k, 2) = site.z();
+    }
+    Rcpp::IntegerVector Cells(topology.cells.begin(), topology.cells.end());
+    for(int& index : Cells) {
+      index++;
+    }
+    Rcpp::List Voronoi = Rcpp::List::create(
+      Rcpp::Named("sites")     = Sites,
+      Rcpp::Named("vertices")  = voronoiVerticesMatrix(vvertices),
+      Rcpp::Named("offsets")   = Rcpp::wrap(offsets),
+      Rcpp::Named("cells")     = Cells,
+      Rcpp::Named("neighbors") = Rcpp::wrap(topology.neighbors),
+      Rcpp::Named("mapping")   = rowMapping(mapping)
+    );
+    if(metrics) {
+      Voronoi["metrics"] = Metrics;
+    }
+    profile.stage("conversion");
+    if(profiling) {
+      profile.objects(Voronoi);
+      Voronoi.attr("profile") = profile.toList();
+    }
+    return Voronoi;
+  }
+  // the meshes of the cells are computed in parallel and written at their
+  // final places in a single render-ready mesh, whose size is known from the
+  // sizes of the cells; with a tolerance, the levels of the adaptive
+  // subdivisions of the cells are computed first, and give these sizes
+  const bool adaptive = tolerance > 0;
+  const int level = adaptive ? 0 : niter - 1;
+  if(level > maxMeshLevel) {
+    Rcpp::stop("The mesh is too large; reduce the number of iterations.");
+  }
+  const int n = 1 << level;
+  const double center[3] = {O(0), O(1), O(2)};
+  std::vector<size_t> vertexOffsets(ncells + 1, 0);
+  std::vector<size_t> triangleOffsets(ncells + 1, 0);
+  // the levels of the k-th cell start at 2*offsets[k] for its edges and at
+  // offsets[k] for its faces
+  std::vector<int> edgeLevels, faceLevels;
+  // bytes of the scratch buffers, summed by thread
+  std::vector<size_t> scratchBytes(std::max(1, nthreads), 0);
+  if(adaptive) {
+    edgeLevels.resize(2 * offsets[ncells]);
+    faceLevels.resize(offsets[ncells]);
+    parallelFor(ncells, nthreads, [&](int begin, int end, int thread) {
+      FaceScratch scratch;
+      std::vector<double> cell;
+      for(int k = begin; k < end; k++) {
+        const int cellsize = offsets[k + 1] - offsets[k];
+        cell.resize(3 * (cellsize + 1));
+        for(int i = 0; i < cellsize; i++) {
+          const double* p = &vvertices[3 * topology.cells[offsets[k] + i]];
+          std::copy(p, p + 3, &cell[3*i]);
+        }
+        const SPoint3 site =
+          vhs[k]->point().get_projection(ball.center(), radius);
+        cell[3 * cellsize]     = site.x();
+        cell[3 * cellsize + 1] = site.y();
+        cell[3 * cellsize + 2] = site.z();
+        starLayout(cell.data(), cellsize, tolerance, radius, center, scratch);
+        const AdaptiveLayout& layout = scratch.layout;
+        std::copy(
+          layout.edgeLevels.begin(), layout.edgeLevels.end(),
+          &edgeLevels[2 * offsets[k]]
+        );
+        std::copy(
+          layout.faceLevels.begin(), layout.faceLevels.end(),
+          &faceLevels[offsets[k]]
+        );
+        vertexOffsets[k + 1] = layout.interiorPoints[cellsize];
+        triangleOffsets[k + 1] = layout.triangles[cellsize];
+      }
+      scratchBytes[thread] += bufferBytes(scratch) + bufferBytes(cell);
+    });
+    profile.stage("levels");
+  } else {
+    for(int k = 0; k < ncells; k++) {
+      const int cellsize = offsets[k + 1] - offsets[k];
+      vertexOffsets[k + 1] = starMeshVertices(cellsize, n);
+      triangleOffsets[k + 1] = starMeshTriangles(cellsize, n);
+    }
+  }
+  for(int k = 0; k < ncells; k++) {
+    vertexOffsets[k + 1] += vertexOffsets[k];
+    triangleOffsets[k + 1] += triangleOffsets[k];
+  }
+  const size_t nmeshVertices = vertexOffsets[ncells];
+  const size_t nmeshTriangles = triangleOffsets[ncells];
+  if(nmeshVertices > size_t(INT_MAX) || 3 * nmeshTriangles > size_t(INT_MAX)) {
+    Rcpp::stop("The mesh is too large; reduce the number of iterations.");
+  }
+  // in the compact form, the vertices are single-precision positions and the
+  // triangles of the cells are given by their offsets, their indices being
+  // written to a temporary buffer and then delta-encoded; the gradient of the
+  // vertices, if requested, is single-precision as well
+  Rcpp::NumericMatrix MeshVertices(
+    compact ? 0 : 6, compact ? 0 : nmeshVertices
+  );
+  Rcpp::RawVector MeshPositions(
+    compact ? 3 * sizeof(float) * nmeshVertices : 0
+  );
+  Rcpp::IntegerMatrix MeshIndices(3, compact ? 0 : nmeshTriangles);
+  std::vector<int> indices(compact ? 3 * nmeshTriangles : 0);
+  Rcpp::IntegerVector MeshIds(compact ? 0 : nmeshTriangles);
+  Rcpp::NumericVector MeshGradient(gradient && !compact ? nmeshVertices : 0);
+  Rcpp::RawVector MeshGradient32(
+    gradient && compact ? sizeof(float) * nmeshVertices : 0
+  );
+  double* vbuffer = MeshVertices.begin();
+  float* pbuffer = reinterpret_cast<float*>(MeshPositions.begin());
+  int* ibuffer = compact ? indices.data() : MeshIndices.begin();
+  int* idbuffer = MeshIds.begin();
+  double* gbuffer = MeshGradient.begin();
+  float* g32buffer = reinterpret_cast<float*>(MeshGradient32.begin());
+  std::vector<int> local(adaptive ? 0 : 3 * n * n);
+  if(!adaptive) {
+    triangleFaces(level, local.data(), 0);
+  }
+  std::vector<double> sites(3 * ncells);
+  parallelFor(ncells, nthreads, [&](int begin, int end, int thread) {
+    FaceScratch scratch;
+    VoronoiCell vcell;
+    for(int k = begin; k < end; k++) {
+      voronoiCell(
+        dtos, vhs[k], &topology.cells[offsets[k]], offsets[k + 1] - offsets[k],
+        vvertices, level,
+        adaptive ? &edgeLevels[2 * offsets[k]] : nullptr,
+        adaptive ? &faceLevels[offsets[k]] : nullptr, center,
+        local.data(), scratch, vcell
+      );
+      std::copy(vcell.site, vcell.site + 3, &sites[3*k]);
+      if(compact) {
+        packMeshCompact(
+          vcell.mesh, vertexOffsets[k], triangleOffsets[k], pbuffer, ibuffer
+        );
+        if(gradient) {
+          cellGradient(vcell, center, g32buffer + vertexOffsets[k]);
+        }
+        continue;
+      }
+      packMesh(
+        vcell.mesh, center, vertexOffsets[k], triangleOffsets[k], vbuffer,
+        ibuffer
+      );
+      std::fill(
+        idbuffer + triangleOffsets[k], idbuffer + triangleOffsets[k + 1], k + 1
+      );
+      if(gradient) {
+        cellGradient(vcell, center, gbuffer + vertexOffsets[k]);
       }
     }
-    const Rcpp::NumericVector A = Cell(Rcpp::_, 0);
-    const Rcpp::NumericVector B = Cell(Rcpp::_, 1);
-    const Rcpp::NumericVector C = Cell(Rcpp::_, 2);
-    Rcpp::List smesh = sTriangle(A, B, C, radius, O, niter);
-    for(int i = 2; i < cellsize-1; i++) {
-      smesh = joinMeshes(
-        smesh,
-        sTriangle(A, Cell(Rcpp::_, i), Cell(Rcpp::_, i+1), radius, O, niter)
+    scratchBytes[thread] += bufferBytes(scratch) +
+      bufferBytes(vcell.vertices) + bufferBytes(vcell.mesh);
+  });
+  profile.stage("subdivision");
+  profile.count("meshVertices", nmeshVertices);
+  profile.count("meshTriangles", nmeshTriangles);
+  profile.count(
+    "bytes",
+    bufferBytes(vertexOffsets) + bufferBytes(triangleOffsets) +
+      bufferBytes(edgeLevels) + bufferBytes(faceLevels) +
+      bufferBytes(indices) + bufferBytes(local) + bufferBytes(sites) +
+      std::accumulate(scratchBytes.begin(), scratchBytes.end(), size_t(0))
+  );
+  // conversion of the cells to R objects
+  Rcpp::List Voronoi(ncells);
+  for(int k = 0; k < ncells; k++) {
+    const Rcpp::NumericVector site(&sites[3*k], &sites[3*k] + 3);
+    const int cellsize = offsets[k + 1] - offsets[k];
+    Rcpp::NumericMatrix Cell(3, cellsize);
+    Rcpp::IntegerVector Indices(cellsize);
+    for(int i = 0; i < cellsize; i++) {
+      const int index = topology.cells[offsets[k] + i];
+      std::copy(
+        &vvertices[3 * index], &vvertices[3 * index] + 3, &Cell(0, i)
       );
+      Indices(i) = index + 1;
     }
-    //
-    Voronoi(k++) = Rcpp::List::create(
-      Rcpp::Named("site") = site,
-      Rcpp::Named("cell") = Cell,
-      Rcpp::Named("mesh") = smesh
+    const Rcpp::IntegerVector Neighbors(
+      topology.neighbors.begin() + offsets[k],
+      topology.neighbors.begin() + offsets[k + 1]
+    );
+    Voronoi(k) = Rcpp::List::create(
+      Rcpp::Named("site")      = site,
+      Rcpp::Named("cell")      = Cell,
+      Rcpp::Named("indices")   = Indices,
+      Rcpp::Named("neighbors") = Neighbors
+    );
+  }
+  Voronoi.attr("vertices") = voronoiVerticesMatrix(vvertices);
+  Voronoi.attr("mapping") = rowMapping(mapping);
+  if(compact) {
+    const Rcpp::IntegerVector MeshOffsets(
+      triangleOffsets.begin(), triangleOffsets.end()
+    );
+    Rcpp::List Mesh = compactMesh(
+      MeshPositions,
+      encodeIndices(indices.data(), indices.size(), 0, nthreads), MeshOffsets
     );
+    if(gradient) {
+      Mesh["gradient"] = MeshGradient32;
+    }
+    Voronoi.attr("mesh") = Mesh;
+  } else {
+    Rcpp::List Mesh = renderMesh(MeshVertices, MeshIndices, MeshIds);
+    if(gradient) {
+      Mesh["gradient"] = MeshGradient;
+    }
+    Voronoi.attr("mesh") = Mesh;
+  }
+  if(metrics) {
+    Voronoi.attr("metrics") = Metrics;
+  }
+  profile.stage("conversion");
+  if(profiling) {
+    // the R objects of the output: the cells and the attributes
+    profile.objects(Voronoi);
+    for(const char* name : {"vertices", "mapping", "mesh", "metrics"}) {
+      profile.objects(Voronoi.attr(name));
+    }
+    Voronoi.attr("profile") = profile.toList();
   }
   //
   return Voronoi;
@@ -0,0 +1,570 @@
+#include "sphereTessellation.h"
+
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Header of a Voronoï file. It is followed by the sections: the sites (three
+// doubles per site), the Voronoï vertices (three doubles each), the vertices
+// of the meshes (three doubles each), the offsets of the cells (nsites+1
+// int64), the corners of the cells (int32, zero-based indices of Voronoï
+// vertices), their neighbors (int32, zero-based indices of sites) and the
+// triangles of the meshes (three int32 each). The mesh of a cell is the
+// subdivided star triangulation of the cell from its site; it has
+// starMeshVertices(cellsize, 2^level) vertices and
+// starMeshTriangles(cellsize, 2^level) triangles; the meshes are stored one
+// after the other and the indices of the vertices of a triangle are
+// zero-based indices in the mesh of its cell. The numbers are stored in the
+// byte order of the machine which wrote the file, given by `byteOrder`.
+struct VoronoiFileHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t nsites;
+  uint64_t nvertices;
+  uint64_t ncorners;
+  uint64_t nmeshVertices;
+  uint64_t nmeshTriangles;
+  int32_t  level;
+  int32_t  reserved;
+  double   radius;
+  double   center[3];
+};
+
+static_assert(sizeof(VoronoiFileHeader) == 96, "unexpected header padding");
+
+const char voronoiFileMagic[8] = {'S', 'P', 'H', 'T', 'V', 'O', 'R', '\0'};
+const uint32_t voronoiFileVersion = 2;
+const uint32_t byteOrderMark = 0x01020304;
+
+// positions in bytes of the sections of a Voronoï file; the sections holding
+// some doubles come first, so that they are aligned
+struct VoronoiFileLayout {
+  uint64_t sites;
+  uint64_t vertices;
+  uint64_t meshVertices;
+  uint64_t offsets;
+  uint64_t corners;
+  uint64_t neighbors;
+  uint64_t triangles;
+  uint64_t end;
+  explicit VoronoiFileLayout(const VoronoiFileHeader& header) {
+    sites        = sizeof(VoronoiFileHeader);
+    vertices     = sites + 24 * header.nsites;
+    meshVertices = vertices + 24 * header.nvertices;
+    offsets      = meshVertices + 24 * header.nmeshVertices;
+    corners      = offsets + 8 * (header.nsites + 1);
+    neighbors    = corners + 4 * header.ncorners;
+    triangles    = neighbors + 4 * header.ncorners;
+    end          = triangles + 12 * header.nmeshTriangles;
+  }
+};
+
+// writes n elements at the position `pos` of the stream
+template <typename T>
+void writeAt(std::ofstream& out, uint64_t pos, const T* data, size_t n) {
+  out.seekp(std::streamoff(pos));
+  out.write(reinterpret_cast<const char*>(data), n * sizeof(T));
+}
+
+bool isLittleEndian() {
+  const uint32_t one = 1;
+  unsigned char byte;
+  std::memcpy(&byte, &one, 1);
+  return byte == 1;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Computes the Voronoï tessellation and writes it to a file, either in the
+// format described above or as a binary PLY mesh, without building it in
+// memory: the cells are processed by chunks of `chunksize` cells, and only
+// the meshes of one chunk are held at a time. In a PLY file, the vertices
+// have some float coordinates and normals, and each face has the zero-based
+// index of its cell in the property `cell`.
+// [[Rcpp::export]]
+Rcpp::List voronoi_write_cpp(
+    Rcpp::NumericMatrix pts, double radius, Rcpp::NumericVector O, int niter,
+    bool spatialsort, int nthreads, std::string filename, bool ply,
+    int chunksize
+) {
+  // a file with a larger level could not be read back
+  if(niter - 1 > maxMeshLevel) {
+    Rcpp::stop("The mesh is too large; reduce the number of iterations.");
+  }
+  // ball
+  Traits ball(SPoint3(O(0), O(1), O(2)), radius);
+  // make Delaunay triangulation
+  DToS dtos(ball);
+  std::vector<PointOnSphere> spoints;
+  std::vector<SPoint3> projections;
+  projectPoints(ball, pts, spoints, projections);
+  insertPoints(dtos, spoints, projections, spatialsort, 1);
+  // check dimension
+  int dim = dtos.dimension();
+  if(dim == -2) {
+    Rcpp::stop("The triangulation is empty.");
+  }
+  if(dim == -1) {
+    Rcpp::stop("The triangulation contains only one vertex.");
+  }
+  if(dim == 0) {
+    Rcpp::stop("The triangulation contains only two vertices.");
+  }
+  if(dim == 1) {
+    Rcpp::stop("The triangulation is just a polygon drawn on a circle.");
+  }
+  // messages
+  if(dtos.number_of_ghost_faces() != 0) {
+    Rcpp::warning("There are some ghost faces in the Delaunay triangulation.");
+  }
+  // Voronoï vertices and offsets of the cells; the corners of the cells are
+  // computed by chunks
+  const std::vector<DToS::Face_handle> fhs = indexFaces(dtos);
+  const std::vector<double> vvertices = voronoiVertices(dtos, fhs, nthreads);
+  const std::vector<DToS::Vertex_handle> vhs = sortedVertices(dtos);
+  const int ncells = vhs.size();
+  const std::vector<size_t> offsets = voronoiOffsets(dtos, vhs, nthreads);
+  const int level = niter - 1;
+  const int n = 1 << level;
+  const double center[3] = {O(0), O(1), O(2)};
+  VoronoiFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, voronoiFileMagic, 8);
+  header.version        = voronoiFileVersion;
+  header.byteOrder      = byteOrderMark;
+  header.nsites         = ncells;
+  header.nvertices      = fhs.size();
+  header.ncorners       = offsets[ncells];
+  header.level          = level;
+  header.radius         = radius;
+  std::copy(center, center + 3, header.center);
+  for(int k = 0; k < ncells; k++) {
+    const int cellsize = offsets[k + 1] - offsets[k];
+    header.nmeshVertices += starMeshVertices(cellsize, n);
+    header.nmeshTriangles += starMeshTriangles(cellsize, n);
+  }
+  if(ply && header.nmeshVertices > UINT32_MAX) {
+    Rcpp::stop("The mesh is too large for a PLY file.");
+  }
+  // the positions of all sections are known, so each chunk is written at its
+  // final places
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  if(!out) {
+    Rcpp::stop("Cannot open the file '" + filename + "'.");
+  }
+  const VoronoiFileLayout layout(header);
+  uint64_t plyVertices = 0, plyFaces = 0;
+  if(ply) {
+    std::string plyHeader =
+      std::string("ply\nformat ") +
+      (isLittleEndian() ? "binary_little_endian" : "binary_big_endian") +
+      " 1.0\ncomment Voronoi tessellation written by sphereTessellation\n" +
+      "element vertex " + std::to_string(header.nmeshVertices) + "\n" +
+      "property float x\nproperty float y\nproperty float z\n" +
+      "property float nx\nproperty float ny\nproperty float nz\n" +
+      "element face " + std::to_string(header.nmeshTriangles) + "\n" +
+      "property list uchar uint vertex_indices\nproperty uint cell\n" +
+      "end_header\n";
+    out.write(plyHeader.data(), plyHeader.size());
+    plyVertices = plyHeader.size();
+    plyFaces = plyVertices + 24 * header.nmeshVertices;
+  } else {
+    writeAt(out, 0, &header, 1);
+    writeAt(out, layout.vertices, vvertices.data(), vvertices.size());
+  }
+  std::vector<int> local(3 * n * n);
+  triangleFaces(level, local.data(), 0);
+  std::vector<int> cells, neighbors;
+  std::vector<int64_t> cellOffsets;
+  std::vector<size_t> vertexOffsets, triangleOffsets;
+  std::vector<double> sites, meshVertices;
+  std::vector<int> triangles;
+  std::vector<float> plyVertexBuffer;
+  std::vector<char> plyFaceBuffer;
+  uint64_t vbase = 0, tbase = 0;
+  chunksize = std::max(1, chunksize);
+  for(int begin = 0, end; begin < ncells; begin = end) {
+    end = begin + std::min(chunksize, ncells - begin);
+    const int m = end - begin;
+    const size_t base = offsets[begin];
+    cells.resize(offsets[end] - base);
+    neighbors.resize(offsets[end] - base);
+    voronoiCorners(
+      dtos, vhs, offsets, begin, end, nthreads, cells.data(),
+      neighbors.data()
+    );
+    // places of the meshes of the cells in the buffers of the chunk
+    vertexOffsets.assign(m + 1, 0);
+    triangleOffsets.assign(m + 1, 0);
+    for(int i = 0; i < m; i++) {
+      const int cellsize = offsets[begin + i + 1] - offsets[begin + i];
+      vertexOffsets[i + 1] =
+        vertexOffsets[i] + starMeshVertices(cellsize, n);
+      triangleOffsets[i + 1] =
+        triangleOffsets[i] + starMeshTriangles(cellsize, n);
+    }
+    const size_t nvertices = vertexOffsets[m];
+    const size_t ntriangles = triangleOffsets[m];
+    if(ply) {
+      plyVertexBuffer.resize(6 * nvertices);
+      plyFaceBuffer.resize(17 * ntriangles);
+    } else {
+      sites.resize(3 * m);
+      meshVertices.resize(3 * nvertices);
+      triangles.resize(3 * ntriangles);
+    }
+    parallelFor(m, nthreads, [&](int first, int last, int) {
+      FaceScratch scratch;
+      VoronoiCell vcell;
+      for(int i = first; i < last; i++) {
+        const int k = begin + i;
+        voronoiCell(
+          dtos, vhs[k], &cells[offsets[k] - base], offsets[k + 1] - offsets[k],
+          vvertices, level, nullptr, nullptr, center, local.data(), scratch,
+          vcell
+        );
+        const std::vector<double>& mv = vcell.mesh.vertices;
+        const std::vector<int>& mf = vcell.mesh.faces;
+        if(!ply) {
+          std::copy(vcell.site, vcell.site + 3, &sites[3*i]);
+          std::copy(mv.begin(), mv.end(), &meshVertices[3*vertexOffsets[i]]);
+          std::copy(mf.begin(), mf.end(), &triangles[3*triangleOffsets[i]]);
+          continue;
+        }
+        float* pv = &plyVertexBuffer[6*vertexOffsets[i]];
+        for(size_t j = 0; j < mv.size(); j += 3) {
+          for(int c = 0; c < 3; c++) {
+            pv[c] = float(mv[j + c]);
+            pv[3 + c] = float((mv[j + c] - center[c]) / radius);
+          }
+          pv += 6;
+        }
+        char* pf = &plyFaceBuffer[17*triangleOffsets[i]];
+        const uint32_t vfirst = uint32_t(vbase + vertexOffsets[i]);
+        const uint32_t cell = uint32_t(k);
+        for(size_t j = 0; j < mf.size(); j += 3) {
+          const uint32_t face[4] = {
+            vfirst + mf[j], vfirst + mf[j + 1], vfirst + mf[j + 2], cell
+          };
+          *pf = 3;
+          std::memcpy(pf + 1, face, 16);
+          pf += 17;
+        }
+      }
+    });
+    if(ply) {
+      writeAt(
+        out, plyVertices + 24 * vbase, plyVertexBuffer.data(),
+        plyVertexBuffer.size()
+      );
+      writeAt(
+        out, plyFaces + 17 * tbase, plyFaceBuffer.data(), plyFaceBuffer.size()
+      );
+    } else {
+      cellOffsets.assign(offsets.begin() + begin, offsets.begin() + end);
+      for(int& neighbor : neighbors) {
+        neighbor--;
+      }
+      writeAt(out, layout.sites + 24 * uint64_t(begin), sites.data(), 3 * m);
+      writeAt(
+        out, layout.meshVertices + 24 * vbase, meshVertices.data(),
+        meshVertices.size()
+      );
+      writeAt(
+        out, layout.offsets + 8 * uint64_t(begin), cellOffsets.data(), m
+      );
+      writeAt(out, layout.corners + 4 * base, cells.data(), cells.size());
+      writeAt(
+        out, layout.neighbors + 4 * base, neighbors.data(), neighbors.size()
+      );
+      writeAt(
+        out, layout.triangles + 12 * tbase, triangles.data(),
+        triangles.size()
+      );
+    }
+    vbase += nvertices;
+    tbase += ntriangles;
+    if(!out) {
+      Rcpp::stop("Failed to write the file '" + filename + "'.");
+    }
+    Rcpp::checkUserInterrupt();
+  }
+  if(!ply) {
+    const int64_t last = offsets[ncells];
+    writeAt(out, layout.offsets + 8 * uint64_t(ncells), &last, 1);
+  }
+  out.close();
+  if(!out) {
+    Rcpp::stop("Failed to write the file '" + filename + "'.");
+  }
+  return Rcpp::List::create(
+    Rcpp::Named("sites")         = double(header.nsites),
+    Rcpp::Named("vertices")      = double(header.nvertices),
+    Rcpp::Named("meshVertices")  = double(header.nmeshVertices),
+    Rcpp::Named("meshTriangles") = double(header.nmeshTriangles)
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Read-only memory mapping of a file; on Windows the file is read in memory.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& filename) {
+#ifdef _WIN32
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if(!in) {
+      Rcpp::stop("Cannot open the file '" + filename + "'.");
+    }
+    buffer.resize(size_t(in.tellg()));
+    in.seekg(0);
+    in.read(buffer.data(), buffer.size());
+    if(!in) {
+      Rcpp::stop("Failed to read the file '" + filename + "'.");
+    }
+    bytes = buffer.data();
+    length = buffer.size();
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+      Rcpp::stop("Cannot open the file '" + filename + "'.");
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      Rcpp::stop("The file '" + filename + "' is not a Voronoï file.");
+    }
+    length = size_t(st.st_size);
+    void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+      Rcpp::stop("Cannot map the file '" + filename + "' in memory.");
+    }
+    bytes = static_cast<const char*>(map);
+#endif
+  }
+  ~MappedFile() {
+#ifndef _WIN32
+    munmap(const_cast<char*>(bytes), length);
+#endif
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  const char* data() const {
+    return bytes;
+  }
+  size_t size() const {
+    return length;
+  }
+private:
+  const char*       bytes;
+  size_t            length;
+#ifdef _WIN32
+  std::vector<char> buffer;
+#endif
+};
+
+// header of a Voronoï file, checked against the size of the file
+VoronoiFileHeader readHeader(
+    const MappedFile& file, const std::string& filename
+) {
+  VoronoiFileHeader header;
+  if(file.size() < sizeof(header)) {
+    Rcpp::stop("The file '" + filename + "' is not a Voronoï file.");
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if(std::memcmp(header.magic, voronoiFileMagic, 8) != 0) {
+    Rcpp::stop("The file '" + filename + "' is not a Voronoï file.");
+  }
+  if(header.version != voronoiFileVersion) {
+    Rcpp::stop("Unsupported version of the file '" + filename + "'.");
+  }
+  if(header.byteOrder != byteOrderMark) {
+    Rcpp::stop(
+      "The file '" + filename + "' has been written on a machine with " +
+      "another byte order."
+    );
+  }
+  if(header.nsites > uint64_t(INT_MAX) ||
+     header.nvertices > uint64_t(INT_MAX) ||
+     header.level < 0 || header.level > maxMeshLevel ||
+     VoronoiFileLayout(header).end != file.size()) {
+    Rcpp::stop("The file '" + filename + "' is corrupted.");
+  }
+  return header;
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// [[Rcpp::export]]
+Rcpp::List voronoi_file_info(std::string filename) {
+  const MappedFile file(filename);
+  const VoronoiFileHeader header = readHeader(file, filename);
+  return Rcpp::List::create(
+    Rcpp::Named("sites")         = double(header.nsites),
+    Rcpp::Named("vertices")      = double(header.nvertices),
+    Rcpp::Named("meshVertices")  = double(header.nmeshVertices),
+    Rcpp::Named("meshTriangles") = double(header.nmeshTriangles),
+    Rcpp::Named("iterations")    = header.level + 1,
+    Rcpp::Named("radius")        = header.radius,
+    Rcpp::Named("center")        = Rcpp::NumericVector(
+      header.center, header.center + 3
+    )
+  );
+}
+
+// -------------------------------------------------------------------------- //
+// -------------------------------------------------------------------------- //
+// Reads the cells `ids` (one-based) of a Voronoï file, or all cells if `all`
+// is true, in the form of the output of voronoi_cpp; the matrix of the
+// Voronoï vertices is attached only when all cells are read. Only the
+// sections of the selected cells are touched.
+// [[Rcpp::export]]
+Rcpp::List voronoi_read_cpp(
+    std::string filename, Rcpp::IntegerVector ids, bool all
+) {
+  const MappedFile file(filename);
+  const VoronoiFileHeader header = readHeader(file, filename);
+  const VoronoiFileLayout layout(header);
+  const char* data = file.data();
+  const double* sites =
+    reinterpret_cast<const double*>(data + layout.sites);
+  const double* vvertices =
+    reinterpret_cast<const double*>(data + layout.vertices);
+  const double* meshVertices =
+    reinterpret_cast<const double*>(data + layout.meshVertices);
+  const int64_t* offsets =
+    reinterpret_cast<const int64_t*>(data + layout.offsets);
+  const int32_t* corners =
+    reinterpret_cast<const int32_t*>(data + layout.corners);
+  const int32_t* neighbors =
+    reinterpret_cast<const int32_t*>(data + layout.neighbors);
+  const int32_t* triangles =
+    reinterpret_cast<const int32_t*>(data + layout.triangles);
+  const int nsites = header.nsites;
+  const int n = 1 << header.level;
+  // places of the meshes of the cells
+  std::vector<uint64_t> vertexOffsets(nsites + 1, 0);
+  std::vector<uint64_t> triangleOffsets(nsites + 1, 0);
+  if(offsets[0] != 0 || uint64_t(offsets[nsites]) != header.ncorners) {
+    Rcpp::stop("The file '" + filename + "' is corrupted.");
+  }
+  for(int k = 0; k < nsites; k++) {
+    const int64_t cellsize = offsets[k + 1] - offsets[k];
+    if(cellsize < 3 || cellsize > INT_MAX) {
+      Rcpp::stop("The file '" + filename + "' is corrupted.");
+    }
+    vertexOffsets[k + 1] = vertexOffsets[k] + starMeshVertices(cellsize, n);
+    triangleOffsets[k + 1] =
+      triangleOffsets[k] + starMeshTriangles(cellsize, n);
+  }
+  if(vertexOffsets[nsites] != header.nmeshVertices ||
+     triangleOffsets[nsites] != header.nmeshTriangles) {
+    Rcpp::stop("The file '" + filename + "' is corrupted.");
+  }
+  // selected cells, zero-based
+  std::vector<int> selection;
+  if(all) {
+    selection.resize(nsites);
+    for(int k = 0; k < nsites; k++) {
+      selection[k] = k;
+    }
+  } else {
+    selection.reserve(ids.size());
+    for(const int id : ids) {
+      if(id == NA_INTEGER || id < 1 || id > nsites) {
+        Rcpp::stop("Invalid cell index: " + std::to_string(id) + ".");
+      }
+      selection.push_back(id - 1);
+    }
+  }
+  const int ncells = selection.size();
+  size_t nmeshVertices = 0, nmeshTriangles = 0;
+  for(const int k : selection) {
+    nmeshVertices += vertexOffsets[k + 1] - vertexOffsets[k];
+    nmeshTriangles += triangleOffsets[k + 1] - triangleOffsets[k];
+  }
+  if(nmeshVertices > size_t(INT_MAX) || 3 * nmeshTriangles > size_t(INT_MAX)) {
+    Rcpp::stop("The mesh is too large; read fewer cells.");
+  }
+  Rcpp::NumericMatrix MeshVertices(6, nmeshVertices);
+  Rcpp::IntegerMatrix MeshIndices(3, nmeshTriangles);
+  Rcpp::IntegerVector MeshIds(nmeshTriangles);
+  Rcpp::List Voronoi(ncells);
+  const double* O = header.center;
+  double* pv = MeshVertices.begin();
+  int* pi = MeshIndices.begin();
+  int* pid = MeshIds.begin();
+  int vbase = 0;
+  for(int c = 0; c < ncells; c++) {
+    const int k = selection[c];
+    const int cellsize = offsets[k + 1] - offsets[k];
+    Rcpp::NumericMatrix Cell(3, cellsize);
+    Rcpp::IntegerVector Indices(cellsize);
+    Rcpp::IntegerVector Neighbors(cellsize);
+    for(int i = 0; i < cellsize; i++) {
+      const int index = corners[offsets[k] + i];
+      if(index < 0 || uint64_t(index) >= header.nvertices) {
+        Rcpp::stop("The file '" + filename + "' is corrupted.");
+      }
+      const int neighbor = neighbors[offsets[k] + i];
+      if(neighbor < 0 || neighbor >= nsites) {
+        Rcpp::stop("The file '" + filename + "' is corrupted.");
+      }
+      std::copy(&vvertices[3 * index], &vvertices[3 * index] + 3, &Cell(0, i));
+      Indices(i) = index + 1;
+      Neighbors(i) = neighbor + 1;
+    }
+    Voronoi(c) = Rcpp::List::create(
+      Rcpp::Named("site")      = Rcpp::NumericVector(
+        &sites[3*k], &sites[3*k] + 3
+      ),
+      Rcpp::Named("cell")      = Cell,
+      Rcpp::Named("indices")   = Indices,
+      Rcpp::Named("neighbors") = Neighbors
+    );
+    // mesh of the cell
+    for(uint64_t v = vertexOffsets[k]; v < vertexOffsets[k + 1]; v++) {
+      for(int j = 0; j < 3; j++) {
+        pv[j] = meshVertices[3*v + j];
+        pv[3 + j] = pv[j] - O[j];
+      }
+      pv += 6;
+    }
+    // the indices are checked against the number of vertices of the mesh of
+    // the cell, since the file is mapped and may have been altered
+    const int cellVertices = vertexOffsets[k + 1] - vertexOffsets[k];
+    for(uint64_t t = triangleOffsets[k]; t < triangleOffsets[k + 1]; t++) {
+      for(int j = 0; j < 3; j++) {
+        const int index = triangles[3*t + j];
+        if(index < 0 || index >= cellVertices) {
+          Rcpp::stop("The file '" + filename + "' is corrupted.");
+        }
+        *pi++ = index + vbase + 1;
+      }
+      *pid++ = c + 1;
+    }
+    vbase += cellVertices;
+  }
+  if(all) {
+    const int nvvertices = header.nvertices;
+    Rcpp::NumericMatrix Vertices(nvvertices, 3);
+    for(int f = 0; f < nvvertices; f++) {
+      for(int j = 0; j < 3; j++) {
+        Vertices(f, j) = vvertices[3*f + j];
+      }
+    }
+    Voronoi.attr("vertices") = Vertices;
+  }
+  Voronoi.attr("mesh") = renderMesh(MeshVertices, MeshIndices, MeshIds);
+  return Voronoi;
+}